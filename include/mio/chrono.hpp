@@ -12,7 +12,10 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <chrono>
+#include <mutex>
+#include <thread>
 #include <string>
 #include <sstream>
 #include <iomanip>
@@ -21,6 +24,10 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/date_time.hpp>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 namespace mio
 {
     /// @brief 时间模块
@@ -74,6 +81,148 @@ namespace mio
                 return mio::chrono::now() - this->start_;
             }
         };
+
+        /**
+         * @brief TSC 时钟
+         * @details 热路径只读取 rdtsc, 由 to_time 按校准结果换算为 与 now() 相同的纳秒时间.
+         * 需要 invariant TSC, 非 x86 平台退化为 steady_clock
+         */
+        class tsc_clock
+        {
+        private:
+            /// 换算基准
+            struct anchor
+            {
+                uint64_t tsc;
+                int64_t time;
+                double ns_per_tick;
+            };
+
+            //换算基准以 seqlock 保护, 后端多个线程换算时 可由其中一个重新校准
+            struct calibration
+            {
+                std::atomic<uint32_t> sequence = 0;
+                std::atomic<uint64_t> tsc;
+                std::atomic<int64_t> time;
+                std::atomic<double> ns_per_tick;
+                /// 第一次校准的起点 之后的校准以此为基线, 基线越长越精确
+                uint64_t origin_tsc;
+                std::chrono::steady_clock::time_point origin;
+                std::mutex mutex;
+
+                calibration(std::chrono::nanoseconds duration)
+                {
+                    origin = std::chrono::steady_clock::now();
+                    origin_tsc = rdtsc();
+
+                    std::this_thread::sleep_for(duration);
+
+                    auto steady = std::chrono::steady_clock::now();
+                    auto tsc = rdtsc();
+                    this->store({tsc, mio::chrono::now().count(), static_cast<double>((steady - origin).count()) / static_cast<double>(tsc - origin_tsc)});
+                }
+
+                anchor load() const
+                {
+                    while (1)
+                    {
+                        auto sequence = this->sequence.load(std::memory_order_acquire);
+                        anchor ret{tsc.load(std::memory_order_relaxed), time.load(std::memory_order_relaxed), ns_per_tick.load(std::memory_order_relaxed)};
+                        std::atomic_thread_fence(std::memory_order_acquire);
+                        if (!(sequence & 1) && sequence == this->sequence.load(std::memory_order_relaxed))
+                            return ret;
+                    }
+                }
+
+                void store(const anchor &value)
+                {
+                    auto sequence = this->sequence.load(std::memory_order_relaxed);
+                    this->sequence.store(sequence + 1, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_release);
+                    tsc.store(value.tsc, std::memory_order_relaxed);
+                    time.store(value.time, std::memory_order_relaxed);
+                    ns_per_tick.store(value.ns_per_tick, std::memory_order_relaxed);
+                    this->sequence.store(sequence + 2, std::memory_order_release);
+                }
+            };
+
+            static calibration &get()
+            {
+                static calibration calibration_(std::chrono::milliseconds(10));
+                return calibration_;
+            }
+
+        public:
+            /**
+             * @brief 读取 TSC
+             *
+             * @return uint64_t
+             */
+            static uint64_t rdtsc() noexcept
+            {
+#if defined(__x86_64__) || defined(__i386__)
+                return __rdtsc();
+#else
+                return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+            }
+
+            /**
+             * @brief 重新校准
+             * @details 第一次调用 to_time 时会自动校准, 之后不再阻塞: 以第一次校准为基线重新计算频率, 减小累积误差.
+             * 换算结果保持连续单调, 不跟随系统时间的调整. 可与 to_time 并发调用
+             */
+            static void calibrate()
+            {
+                auto &calibration_ = get();
+                std::lock_guard lock(calibration_.mutex);
+
+                auto steady = std::chrono::steady_clock::now();
+                auto tsc = rdtsc();
+                auto value = calibration_.load();
+                value.time = to_time(tsc).count();
+                value.tsc = tsc;
+
+                if (tsc != calibration_.origin_tsc)
+                    value.ns_per_tick = static_cast<double>((steady - calibration_.origin).count()) / static_cast<double>(tsc - calibration_.origin_tsc);
+                calibration_.store(value);
+            }
+
+            /**
+             * @brief 距上次校准超过 interval 时重新校准
+             * @details 未到期时只读取一次 TSC, 可在后端循环中频繁调用
+             * @param interval
+             */
+            static void update(std::chrono::nanoseconds interval = std::chrono::seconds(1))
+            {
+                auto value = get().load();
+                if ((rdtsc() - value.tsc) * value.ns_per_tick >= interval.count())
+                    calibrate();
+            }
+
+            /**
+             * @brief 每个 tick 的纳秒数
+             *
+             * @return double
+             */
+            static double ns_per_tick()
+            {
+                return get().load().ns_per_tick;
+            }
+
+            /**
+             * @brief 将 TSC 换算为时间
+             *
+             * @param tsc rdtsc() 的返回值
+             * @return std::chrono::nanoseconds 与 now() 相同的纪元
+             */
+            static std::chrono::nanoseconds to_time(uint64_t tsc)
+            {
+                auto value = get().load();
+                auto diff = static_cast<int64_t>(tsc - value.tsc);
+                return std::chrono::nanoseconds(value.time + static_cast<int64_t>(diff * value.ns_per_tick));
+            }
+        };
     } // namespace chrono
 
     /**
@@ -1,40 +1,154 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <tuple>
-#include <list>
+#include <memory>
 #include <mutex>
-#include <semaphore>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #include <fmt/format.h>
 
 #include <mio/chrono.hpp>
+#include <mio/logging/binary.hpp>
+#include <mio/logging/kv.hpp>
+#include <mio/logging/shm.hpp>
+#include <mio/logging/sink.hpp>
+
+#define MIO_LOG_LEVEL_TRACE 0
+#define MIO_LOG_LEVEL_DEBUG 1
+#define MIO_LOG_LEVEL_INFO 2
+#define MIO_LOG_LEVEL_WARN 3
+#define MIO_LOG_LEVEL_ERROR 4
+#define MIO_LOG_LEVEL_CRITICAL 5
+#define MIO_LOG_LEVEL_OFF 6
+
+/// 编译期最低日志级别 低于该级别的调用不会生成代码
+#ifndef MIO_LOG_ACTIVE_LEVEL
+#define MIO_LOG_ACTIVE_LEVEL MIO_LOG_LEVEL_TRACE
+#endif
+
+/**
+ * @brief 按级别记录日志
+ * @details 低于编译期级别时整条语句被消除, 低于 logger 的运行期级别时 参数不会被求值
+ */
+#define MIO_LOG(logger, lvl, ...)                                      \
+    do                                                                 \
+    {                                                                  \
+        if constexpr (static_cast<int>(lvl) >= MIO_LOG_ACTIVE_LEVEL)   \
+        {                                                              \
+            if ((logger).should_log(lvl))                              \
+                (logger)(__VA_ARGS__);                                 \
+        }                                                              \
+    } while (0)
+
+#define MIO_LOG_TRACE(logger, ...) MIO_LOG(logger, mio::logging::level::trace, __VA_ARGS__)
+#define MIO_LOG_DEBUG(logger, ...) MIO_LOG(logger, mio::logging::level::debug, __VA_ARGS__)
+#define MIO_LOG_INFO(logger, ...) MIO_LOG(logger, mio::logging::level::info, __VA_ARGS__)
+#define MIO_LOG_WARN(logger, ...) MIO_LOG(logger, mio::logging::level::warn, __VA_ARGS__)
+#define MIO_LOG_ERROR(logger, ...) MIO_LOG(logger, mio::logging::level::error, __VA_ARGS__)
+#define MIO_LOG_CRITICAL(logger, ...) MIO_LOG(logger, mio::logging::level::critical, __VA_ARGS__)
 
 namespace mio
 {
+    /// @brief 日志
+    namespace logging
+    {
+        /// 日志级别
+        enum class level : std::uint8_t
+        {
+            trace = MIO_LOG_LEVEL_TRACE,
+            debug = MIO_LOG_LEVEL_DEBUG,
+            info = MIO_LOG_LEVEL_INFO,
+            warn = MIO_LOG_LEVEL_WARN,
+            error = MIO_LOG_LEVEL_ERROR,
+            critical = MIO_LOG_LEVEL_CRITICAL,
+            off = MIO_LOG_LEVEL_OFF,
+        };
+
+        /// 缓冲区写满时的策略
+        enum class overflow : std::uint8_t
+        {
+            /// 等待后端消费
+            block,
+            /// 丢弃新日志并计数
+            drop,
+            /// 从缓冲池取新的缓冲区链接到末尾
+            grow,
+        };
+    }
+
     template <size_t N = 65536>
     class log
     {
     private:
-        struct message
-        {
-            void (*fun)(void *ptr);
-            void *ptr;
-            std::size_t size;
-        };
+        using message = logging::detail::message;
 
+        //布局需与 logging::detail::shm_header 的描述一致: 可写位置, 可读位置 在最前
         class spsc_buffer
         {
         private:
-            char data_[N];
             std::atomic<std::size_t> writable_limit_ = 0;
             std::atomic<std::size_t> readable_limit_ = 0;
+            /// grow 策略下 写满后链接的下一个缓冲区
+            std::atomic<spsc_buffer *> next_ = nullptr;
+            char data_[N];
+
+            bool contains(const void *ptr) const
+            {
+                auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+                auto begin = reinterpret_cast<std::uintptr_t>(data_);
+                return addr >= begin && addr < begin + N;
+            }
+
+            //输出一条消息 并释放堆上的参数
+            void process(message *msg)
+            {
+                msg->fun(msg->ptr, chrono::tsc_clock::to_time(msg->tsc));
+                if (!this->contains(msg->ptr))
+                    ::operator delete(msg->ptr);
+            }
 
         public:
-            message *alloc(std::size_t size)
+            static constexpr std::size_t data_offset()
+            {
+                return offsetof(spsc_buffer, data_);
+            }
+
+            spsc_buffer *next() const
+            {
+                return next_.load();
+            }
+
+            //旧缓冲区的写入 先于 next_ 发布, 后端看到 next_ 时旧缓冲区已不再写入
+            void link(spsc_buffer *next)
             {
-                auto all_size = size + sizeof(message);
+                next_ = next;
+            }
+
+            /**
+             * @brief 分配一条消息
+             * @details 超过半个缓冲区的消息 参数放到堆上, 缓冲区只保存消息头, 由 drain 释放
+             * @param size 参数大小
+             * @param wait 写满时是否等待, 不等待时返回 nullptr
+             * @return message*
+             */
+            message *alloc(std::size_t size, bool wait = true)
+            {
+                //按消息头对齐 保证下一条消息头与参数对齐
+                auto aligned = (size + alignof(message) - 1) / alignof(message) * alignof(message);
+                bool large = 2 * (aligned + 2 * sizeof(message)) > N;
+                auto all_size = (large ? 0 : aligned) + sizeof(message);
 
                 auto writable_limit = writable_limit_.load();
                 auto readable_limit = readable_limit_.load();
@@ -47,15 +161,27 @@ namespace mio
                 //写满了等待 可写
                 while (N - (writable_limit - readable_limit) < all_size)
                 {
+                    if (!wait)
+                        return nullptr;
+
                     readable_limit_.wait(readable_limit);
                     readable_limit = readable_limit_.load();
                 }
 
-                ret->size = all_size;
-                ret->ptr = ptr;
+                ret->size = static_cast<std::uint32_t>(all_size);
+                ret->flags = 0;
+                ret->ptr = large ? ::operator new(size) : ptr;
                 return ret;
             }
 
+            //放回缓冲池前 由后端调用
+            void reset()
+            {
+                writable_limit_ = 0;
+                readable_limit_ = 0;
+                next_ = nullptr;
+            }
+
             size_t size() const
             {
                 return writable_limit_ - readable_limit_;
@@ -66,108 +192,901 @@ namespace mio
                 writable_limit_ += msg->size;
             }
 
+            //队首消息 为空时返回 nullptr
             message *front()
             {
-                return (message *)&data_[readable_limit_ % N];
+                auto readable_limit = readable_limit_.load();
+                if (readable_limit == writable_limit_.load())
+                    return nullptr;
+                return reinterpret_cast<message *>(&data_[readable_limit % N]);
             }
 
+            //输出并移除队首消息
             void pop(message *msg)
             {
+                this->process(msg);
                 this->readable_limit_ += msg->size;
                 this->readable_limit_.notify_one();
             }
+
+            //批量消费 最多处理 budget 条, 只更新一次 readable_limit_
+            size_t drain(size_t budget)
+            {
+                auto readable_limit = readable_limit_.load();
+                auto writable_limit = writable_limit_.load();
+
+                size_t count = 0;
+                for (; count < budget && readable_limit != writable_limit; count++)
+                {
+                    auto msg = reinterpret_cast<message *>(&data_[readable_limit % N]);
+                    this->process(msg);
+                    readable_limit += msg->size;
+                }
+
+                if (count)
+                {
+                    readable_limit_ = readable_limit;
+                    readable_limit_.notify_one();
+                }
+                return count;
+            }
         };
 
-        inline static std::mutex mutex_;
-        inline static std::list<spsc_buffer *> list_;
-        inline static std::counting_semaphore semaphore_{0};
+        /// 注册表容量 同时存在的 log 上限
+        static constexpr std::size_t REGISTRY_SIZE = 4096;
+
+        /// 注册表 空位为 nullptr, 前端注册与注销均无锁
+        inline static std::atomic<log *> registry_[REGISTRY_SIZE] = {};
+        /// 注册表使用过的最大下标 + 1
+        inline static std::atomic<std::size_t> registry_size_ = 0;
+        /// 后端线程数上限
+        static constexpr std::size_t MAX_SHARDS = 64;
+
+        /// 每个后端线程的状态 前端按所属分片唤醒
+        struct alignas(64) worker
+        {
+            /// 遍历注册表的次数 奇数表示正在遍历
+            std::atomic<std::size_t> pass = 0;
+            /// 是否休眠 只有休眠时前端才需要唤醒
+            std::atomic<bool> sleeping = false;
+            /// eventcount 每次唤醒加一
+            std::atomic<std::uint32_t> epoch = 0;
+        };
+
+        inline static worker workers_[MAX_SHARDS];
+        /// 后端线程数 注册表下标 % shards_ 为 log 所属的分片
+        inline static std::atomic<std::size_t> shards_ = 1;
+        /// 当前后端线程处理的分片
+        inline static thread_local std::size_t shard_index_ = 0;
         inline static std::atomic<bool> is_run_ = false;
-        inline static std::atomic<std::size_t> count_ = 0;
+        /// 是否按记录时间归并输出
+        inline static std::atomic<bool> ordered_ = false;
+        /// 归并时 晚于 当前时间 - window_ 的消息暂不输出, 等待其他线程更早的消息
+        inline static std::atomic<std::int64_t> window_ = 0;
+        /// 还有消息在等待窗口内 后端不能休眠, 每个后端线程一份
+        inline static thread_local bool pending_ = false;
+        /// 格式化缓冲区 每个后端线程一份
+        inline static thread_local fmt::memory_buffer buffer_;
+        /// 归并用的小顶堆 每个后端线程一份
+        inline static thread_local std::vector<std::pair<std::uint64_t, log *>> heap_;
+
+        /// 空闲缓冲区 所有 log 共享
+        inline static std::mutex pool_mutex_;
+        inline static std::vector<std::unique_ptr<spsc_buffer>> pool_;
+
+        /// 后端读取的缓冲区
+        std::atomic<spsc_buffer *> head_;
+        /// 前端写入的缓冲区
+        spsc_buffer *tail_;
+        /// 缓冲区所在的共享内存段 为空时在堆上
+        logging::shm_segment *segment_ = nullptr;
+        /// 所在的注册表位置 由后端回收时为 nullptr
+        std::atomic<log *> *slot_ = nullptr;
+        /// 所属的分片 由该分片的后端线程处理
+        std::size_t shard_ = 0;
+        /// 所属线程已退出 由后端处理完剩余消息后释放
+        std::atomic<bool> retired_ = false;
+        std::atomic<logging::level> level_ = logging::level::trace;
+        std::atomic<logging::overflow> overflow_;
+        std::atomic<std::size_t> dropped_ = 0;
+        std::atomic<logging::kv_format> kv_format_ = logging::kv_format::json;
+
+        //线程退出时 把 local() 创建的 log 交给后端
+        struct local_holder
+        {
+            log *ptr = new log;
+
+            ~local_holder()
+            {
+                //标记后 log 随时可能被后端释放
+                auto shard = ptr->shard_;
+                ptr->retired_ = true;
+                if (workers_[shard].sleeping.load())
+                    wake(shard);
+            }
+        };
+
+        void attach()
+        {
+            for (std::size_t i = 0; i < REGISTRY_SIZE; i++)
+            {
+                log *expected = nullptr;
+                if (!registry_[i].compare_exchange_strong(expected, this))
+                    continue;
+
+                slot_ = &registry_[i];
+                shard_ = i % shards_.load();
+                auto size = registry_size_.load();
+                while (size < i + 1 && !registry_size_.compare_exchange_weak(size, i + 1))
+                    ;
+                return;
+            }
+            throw std::runtime_error("mio::log registry is full");
+        }
+
+        //清空注册表位置后 等待可能还持有本 log 的那次遍历结束
+        void detach()
+        {
+            slot_->store(nullptr);
+            slot_ = nullptr;
+
+            for (std::size_t i = 0; i < shards_.load(); i++)
+            {
+                auto pass = workers_[i].pass.load();
+                if (pass % 2)
+                {
+                    while (workers_[i].pass.load() == pass)
+                        std::this_thread::yield();
+                }
+            }
+        }
+
+        spsc_buffer *acquire()
+        {
+            //共享内存中的缓冲区 直接在共享内存段中分配
+            if (segment_)
+                return new (segment_->allocate(sizeof(spsc_buffer), N, spsc_buffer::data_offset())) spsc_buffer;
+
+            {
+                std::lock_guard lock(pool_mutex_);
+                if (!pool_.empty())
+                {
+                    auto ret = pool_.back().release();
+                    pool_.pop_back();
+                    return ret;
+                }
+            }
+            return new spsc_buffer;
+        }
+
+        void release(spsc_buffer *buffer)
+        {
+            if (segment_)
+            {
+                buffer->~spsc_buffer();
+                segment_->deallocate(buffer);
+                return;
+            }
+
+            buffer->reset();
+            std::lock_guard lock(pool_mutex_);
+            pool_.emplace_back(buffer);
+        }
+
+        //按 overflow 策略分配, drop 时返回 nullptr
+        message *alloc(std::size_t size)
+        {
+            if (auto msg = tail_->alloc(size, false))
+                return msg;
+
+            switch (overflow_.load(std::memory_order_relaxed))
+            {
+            case logging::overflow::drop:
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            case logging::overflow::grow:
+            {
+                auto next = this->acquire();
+                tail_->link(next);
+                tail_ = next;
+                return tail_->alloc(size);
+            }
+            default:
+                return tail_->alloc(size);
+            }
+        }
+
+        //文本日志中的字符串 内联拷贝到参数之后, 只保存偏移与长度
+        struct inline_string
+        {
+            std::size_t offset;
+            std::size_t size;
+        };
+
+        template <typename T>
+        static constexpr bool is_inline_string_v = std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> ||
+                                                   std::is_same_v<T, const char *> || std::is_same_v<T, char *>;
 
-        spsc_buffer buffer_;
-        typename std::list<spsc_buffer *>::iterator iterator_;
+        /// 参数在缓冲区中保存的类型
+        template <typename T>
+        using capture_t = std::conditional_t<is_inline_string_v<std::decay_t<T>>, inline_string,
+                                             std::conditional_t<std::is_same_v<std::decay_t<T>, logging::static_string>, std::string_view, std::decay_t<T>>>;
+
+        template <typename T>
+        static std::string_view inline_view(const T &arg)
+        {
+            if constexpr (std::is_pointer_v<std::decay_t<T>>)
+                return logging::detail::binary_string<const char *>(arg);
+            else
+                return std::string_view(arg);
+        }
+
+        template <typename T>
+        static std::size_t inline_size(const T &arg)
+        {
+            if constexpr (is_inline_string_v<std::decay_t<T>>)
+                return inline_view(arg).size();
+            else
+                return 0;
+        }
+
+        template <typename T>
+        static decltype(auto) capture(T &&arg, char *base, std::size_t &offset)
+        {
+            using type = std::decay_t<T>;
+            if constexpr (is_inline_string_v<type>)
+            {
+                auto str = inline_view(arg);
+                if (str.size())
+                    std::memcpy(base + offset, str.data(), str.size());
+                inline_string ret{offset, str.size()};
+                offset += str.size();
+                return ret;
+            }
+            else if constexpr (std::is_same_v<type, logging::static_string>)
+                return std::string_view(arg);
+            else
+                return std::forward<T>(arg);
+        }
+
+        template <typename T>
+        static decltype(auto) restore(T &arg, const char *base)
+        {
+            if constexpr (std::is_same_v<T, inline_string>)
+                return std::string_view(base + arg.offset, arg.size);
+            else
+                return (arg);
+        }
 
         template <typename Stream, typename Format, size_t... Index, typename... Args>
         void operator()(Stream &stream, Format &&fmt, std::index_sequence<Index...>, Args &&...args)
         {
-            using args_t = std::tuple<Stream &, std::remove_reference_t<Format>, std::remove_reference_t<Args>...>;
+            using args_t = std::tuple<Stream &, std::remove_reference_t<Format>, capture_t<Args>...>;
 
-            auto msg = buffer_.alloc(sizeof(args_t));
-            new (msg->ptr) args_t(stream, std::forward<Format>(fmt), std::forward<Args>(args)...);
-            msg->fun = [](void *ptr)
+            auto msg = this->alloc(sizeof(args_t) + (std::size_t(0) + ... + inline_size(args)));
+            if (!msg)
+                return;
+
+            auto base = static_cast<char *>(msg->ptr) + sizeof(args_t);
+            std::size_t offset = 0;
+            new (msg->ptr) args_t(stream, std::forward<Format>(fmt), capture(std::forward<Args>(args), base, offset)...);
+            msg->fun = [](void *ptr, std::chrono::nanoseconds time)
             {
                 auto *args = reinterpret_cast<args_t *>(ptr);
-                std::get<size_t>(*args);
-                std::get<0>(*args) << fmt::vformat(std::get<1>(*args), fmt::make_format_args(std::get<Index + 2>(*args)...));
+                auto base = static_cast<const char *>(ptr) + sizeof(args_t);
+
+                //Stream 接受时间时 格式化到复用的缓冲区, 以 string_view 一并传入记录时间
+                if constexpr (requires { std::get<0>(*args).write(time, std::string_view()); })
+                {
+                    buffer_.clear();
+                    //编译期格式串 在编译期解析, 后端直接执行
+                    if constexpr (logging::is_compiled_string_v<Format>)
+                        fmt::format_to(std::back_inserter(buffer_), std::get<1>(*args), restore(std::get<Index + 2>(*args), base)...);
+                    else
+                        fmt::vformat_to(std::back_inserter(buffer_), std::get<1>(*args), fmt::make_format_args(restore(std::get<Index + 2>(*args), base)...));
+                    std::get<0>(*args).write(time, std::string_view(buffer_.data(), buffer_.size()));
+
+                    //由写入的后端线程 在其空闲时写出
+                    if constexpr (std::is_base_of_v<logging::flushable, Stream>)
+                        std::get<0>(*args).own(shard_index_);
+                }
+                else
+                {
+                    if constexpr (logging::is_compiled_string_v<Format>)
+                        std::get<0>(*args) << fmt::format(std::get<1>(*args), restore(std::get<Index + 2>(*args), base)...);
+                    else
+                        std::get<0>(*args) << fmt::vformat(std::get<1>(*args), fmt::make_format_args(restore(std::get<Index + 2>(*args), base)...));
+                }
                 args->~args_t();
             };
 
-            buffer_.push(msg);
-            ++count_;
-            semaphore_.release();
+            this->commit(msg);
+        }
+
+        //二进制模式 只拷贝 格式串id 与 参数的原始字节, 由 Stream 直接写出
+        template <typename Stream, typename Format, typename... Args>
+        void binary(Stream &stream, Format &&fmt, Args &&...args)
+        {
+            std::uint32_t id = logging::format_id<std::decay_t<Args>...>(fmt);
+            std::uint32_t size = logging::binary_size(args...);
+            Stream *sink = &stream;
+
+            auto msg = this->alloc(sizeof(sink) + sizeof(id) + sizeof(size) + size);
+            if (!msg)
+                return;
+
+            auto ptr = static_cast<char *>(msg->ptr);
+            std::memcpy(ptr, &sink, sizeof(sink));
+            std::memcpy(ptr + sizeof(sink), &id, sizeof(id));
+            std::memcpy(ptr + sizeof(sink) + sizeof(id), &size, sizeof(size));
+            logging::binary_encode(ptr + sizeof(sink) + sizeof(id) + sizeof(size), args...);
+
+            msg->fun = [](void *ptr, std::chrono::nanoseconds time)
+            {
+                auto data = static_cast<const char *>(ptr);
+                Stream *sink;
+                std::uint32_t id, size;
+                std::memcpy(&sink, data, sizeof(sink));
+                std::memcpy(&id, data + sizeof(sink), sizeof(id));
+                std::memcpy(&size, data + sizeof(sink) + sizeof(id), sizeof(size));
+                sink->write(id, time, data + sizeof(sink) + sizeof(id) + sizeof(size), size);
+            };
+
+            //崩溃恢复需要 格式串定义在记录之前写入共享内存
+            msg->flags = logging::detail::message_binary;
+            if (segment_)
+                segment_->define(id);
+
+            this->commit(msg);
+        }
+
+        //结构化日志 值按二进制编码拷贝, 键与事件名只保存指针
+        template <typename Stream, typename Fields, size_t... Index>
+        void kv_impl(Stream &stream, const char *event, std::index_sequence<Index...>, const Fields &fields)
+        {
+            static_assert((logging::detail::is_kv_key_v<std::tuple_element_t<Index * 2, Fields>> && ...),
+                          "mio::log::kv keys must be string literals");
+
+            using values_t = std::tuple<std::decay_t<std::tuple_element_t<Index * 2 + 1, Fields>>...>;
+
+            struct head
+            {
+                Stream *stream;
+                const char *event;
+                const char *keys[sizeof...(Index) ? sizeof...(Index) : 1];
+                logging::kv_format format;
+            };
+
+            std::size_t size = logging::binary_size(std::get<Index * 2 + 1>(fields)...);
+            auto msg = this->alloc(sizeof(head) + size);
+            if (!msg)
+                return;
+
+            auto ptr = static_cast<char *>(msg->ptr);
+            new (ptr) head{&stream, event, {std::get<Index * 2>(fields)...}, kv_format_.load(std::memory_order_relaxed)};
+            logging::binary_encode(ptr + sizeof(head), std::get<Index * 2 + 1>(fields)...);
+
+            msg->fun = [](void *ptr, std::chrono::nanoseconds time)
+            {
+                auto h = static_cast<head *>(ptr);
+                buffer_.clear();
+                logging::kv_render<std::tuple_element_t<Index, values_t>...>(buffer_, h->format, h->event, h->keys,
+                                                                             static_cast<const char *>(ptr) + sizeof(head));
+                buffer_.push_back('\n');
+
+                if constexpr (requires { h->stream->write(time, std::string_view()); })
+                {
+                    h->stream->write(time, std::string_view(buffer_.data(), buffer_.size()));
+                    if constexpr (std::is_base_of_v<logging::flushable, Stream>)
+                        h->stream->own(shard_index_);
+                }
+                else
+                    *h->stream << fmt::to_string(buffer_);
+            };
+
+            this->commit(msg);
+        }
+
+        template <logging::level Level, typename Stream, typename Format, typename... Args>
+        void write(Stream &stream, Format &&fmt, Args &&...args)
+        {
+            if constexpr (static_cast<int>(Level) >= MIO_LOG_ACTIVE_LEVEL)
+            {
+                if (this->should_log(Level))
+                    this->operator()(stream, std::forward<Format>(fmt), std::forward<Args>(args)...);
+            }
+        }
+
+        void commit(message *msg)
+        {
+            msg->tsc = chrono::tsc_clock::rdtsc();
+            tail_->push(msg);
+
+            //push 为 seq_cst, 与后端 休眠前的检查 构成 dekker 同步, 后端醒着时只有一次读
+            if (workers_[shard_].sleeping.load())
+                wake(shard_);
+        }
+
+        static void wake(std::size_t shard)
+        {
+            workers_[shard].epoch.fetch_add(1);
+            workers_[shard].epoch.notify_one();
+        }
+
+        //处理本 log 的缓冲区链 最多 budget 条, 读完的链接缓冲区放回缓冲池
+        size_t drain_chain(size_t budget)
+        {
+            size_t count = 0;
+            while (count < budget)
+            {
+                auto head = head_.load();
+                count += head->drain(budget - count);
+
+                auto next = head->next();
+                if (!next || head->size())
+                    break;
+
+                head_ = next;
+                this->release(head);
+            }
+            return count;
+        }
+
+        //本 log 缓冲区链的队首消息, 读完的链接缓冲区放回缓冲池
+        message *front()
+        {
+            while (1)
+            {
+                auto head = head_.load();
+                if (auto msg = head->front())
+                    return msg;
+
+                auto next = head->next();
+                if (!next)
+                    return nullptr;
+
+                //看到 next_ 后 再检查一次 旧缓冲区最后的写入
+                if (head->size())
+                    continue;
+
+                head_ = next;
+                this->release(head);
+            }
+        }
+
+        //已退出线程的 log 处理完后 由后端释放
+        static void reclaim(std::size_t index, log *log)
+        {
+            if (log->retired_.load() && !log->size())
+            {
+                registry_[index] = nullptr;
+                log->slot_ = nullptr;
+                delete log;
+            }
+        }
+
+        //遍历所有 log 每个最多处理 budget 条
+        static size_t drain(size_t budget)
+        {
+            if (ordered_.load(std::memory_order_relaxed))
+                return drain_ordered(budget);
+
+            auto &worker = workers_[shard_index_];
+            worker.pass.fetch_add(1);
+
+            size_t count = 0;
+            auto size = registry_size_.load();
+            auto shards = shards_.load();
+            for (std::size_t i = shard_index_; i < size; i += shards)
+            {
+                auto log = registry_[i].load();
+                if (!log)
+                    continue;
+
+                count += log->drain_chain(budget);
+                reclaim(i, log);
+            }
+
+            worker.pass.fetch_add(1);
+            pending_ = false;
+            return count;
+        }
+
+        //按记录时间 k 路归并所有 log 的队首, 最多处理 budget * 非空 log 数 条
+        static size_t drain_ordered(size_t budget)
+        {
+            auto &worker = workers_[shard_index_];
+            worker.pass.fetch_add(1);
+
+            auto greater = std::greater<std::pair<std::uint64_t, log *>>();
+
+            heap_.clear();
+            auto size = registry_size_.load();
+            auto shards = shards_.load();
+            for (std::size_t i = shard_index_; i < size; i += shards)
+            {
+                auto log = registry_[i].load();
+                if (!log)
+                    continue;
+
+                if (auto msg = log->front())
+                    heap_.emplace_back(msg->tsc, log);
+                else
+                    reclaim(i, log);
+            }
+            std::make_heap(heap_.begin(), heap_.end(), greater);
+
+            //stop 之后 不再等待 全部输出
+            auto window = static_cast<std::uint64_t>(window_.load(std::memory_order_relaxed) / chrono::tsc_clock::ns_per_tick());
+            auto limit = is_run_ ? chrono::tsc_clock::rdtsc() - window : UINT64_MAX;
+
+            size_t count = 0;
+            auto max = budget * heap_.size();
+            while (!heap_.empty() && count < max && heap_.front().first <= limit)
+            {
+                std::pop_heap(heap_.begin(), heap_.end(), greater);
+                auto log = heap_.back().second;
+                heap_.pop_back();
+
+                log->head_.load()->pop(log->front());
+                count++;
+
+                if (auto msg = log->front())
+                {
+                    heap_.emplace_back(msg->tsc, log);
+                    std::push_heap(heap_.begin(), heap_.end(), greater);
+                }
+            }
+
+            worker.pass.fetch_add(1);
+            pending_ = !heap_.empty();
+            return count;
         }
 
     public:
-        log()
+        /**
+         * @brief 构造
+         *
+         * @param overflow 缓冲区写满时的策略
+         */
+        log(logging::overflow overflow = logging::overflow::block) : overflow_(overflow)
+        {
+            tail_ = this->acquire();
+            head_ = tail_;
+            this->attach();
+        }
+
+        /**
+         * @brief 构造 缓冲区放在共享内存中
+         * @details 进程崩溃后 可由 logging::shm_recover 恢复尚未写出的二进制记录
+         * @param segment 需要比 log 存活更久
+         * @param overflow 缓冲区写满时的策略
+         */
+        log(logging::shm_segment &segment, logging::overflow overflow = logging::overflow::block)
+            : segment_(&segment), overflow_(overflow)
         {
-            std::lock_guard lock(mutex_);
-            list_.push_back(&buffer_);
-            iterator_ = --list_.end();
+            tail_ = this->acquire();
+            head_ = tail_;
+            this->attach();
         }
 
+        log(const log &) = delete;
+        log &operator=(const log &) = delete;
+
         ~log()
         {
-            std::lock_guard lock(mutex_);
-            list_.erase(iterator_);
+            if (slot_)
+                this->detach();
+
+            for (auto buffer = head_.load(); buffer;)
+            {
+                auto next = buffer->next();
+                this->release(buffer);
+                buffer = next;
+            }
         }
 
+        /**
+         * @brief 当前线程的 log
+         * @details 第一次调用时创建, 线程退出时交给后端, 处理完剩余消息后释放
+         * @return log&
+         */
+        static log &local()
+        {
+            thread_local local_holder holder;
+            return *holder.ptr;
+        }
+
+        /**
+         * @brief 记录一条日志
+         * @details Stream 为 logging::binary_sink 时只记录格式串id 与参数, 不在后端格式化.
+         * fmt 为 FMT_COMPILE("...") 或 "..."_cf 时在编译期解析并检查参数类型, 后端不再解析格式串;
+         * 为 std::string, std::string_view 等运行期字符串时在后端解析
+         * @tparam Stream 输出 需要 operator<<(std::string), 或 write(std::chrono::nanoseconds, std::string_view) 以接收记录时间,
+         * 例如 logging::file_sink
+         * @param stream
+         * @param fmt 格式串
+         * @param args 参数
+         */
         template <typename Stream, typename Format, typename... Args, typename Index = std::make_index_sequence<sizeof...(Args)>>
+            requires(!std::is_convertible_v<Format, const char *>)
         void operator()(Stream &stream, Format &&fmt, Args &&...args)
         {
-            this->operator()(stream, std::forward<Format>(fmt), Index{}, std::forward<Args>(args)...);
+            if constexpr (logging::is_binary_sink_v<Stream>)
+                this->binary(stream, std::forward<Format>(fmt), std::forward<Args>(args)...);
+            else
+                this->operator()(stream, std::forward<Format>(fmt), Index{}, std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief 记录一条日志
+         * @details 字符串字面量格式串 在编译期检查参数类型
+         * @tparam Stream 输出 需要 operator<<(std::string)
+         * @param stream
+         * @param fmt 格式串
+         * @param args 参数
+         */
+        template <typename Stream, typename... Args>
+        void operator()(Stream &stream, fmt::format_string<Args...> fmt, Args &&...args)
+        {
+            fmt::string_view str = fmt;
+            this->operator()(stream, std::string_view(str.data(), str.size()), std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief 记录一条结构化日志
+         * @details LOG.kv(stream, "order", "id", id, "px", px). 值按二进制日志的编码拷贝到缓冲区, 字符串也内联拷贝, 不分配内存;
+         * 后端按 set_kv_format 的格式输出为一行 json 或 logfmt
+         * @tparam Stream 输出 需要 operator<<(std::string), 或 write(std::chrono::nanoseconds, std::string_view)
+         * @param stream
+         * @param event 事件名 字符串字面量
+         * @param fields 键值交替, 键为字符串字面量, 值为算术类型, 枚举, 字符串或指针
+         */
+        template <typename Stream, std::size_t Size, typename... Fields>
+        void kv(Stream &stream, const char (&event)[Size], const Fields &...fields)
+        {
+            static_assert(sizeof...(Fields) % 2 == 0, "mio::log::kv fields must be key value pairs");
+            this->kv_impl(stream, event, std::make_index_sequence<sizeof...(Fields) / 2>(), std::forward_as_tuple(fields...));
+        }
+
+//生成各级别的记录函数
+#define MIO_LOG_LEVEL_FUNCTION(name)                                                                                           \
+    template <typename Stream, typename Format, typename... Args>                                                              \
+        requires(!std::is_convertible_v<Format, const char *>)                                                                 \
+    void name(Stream &stream, Format &&fmt, Args &&...args)                                                                    \
+    {                                                                                                                          \
+        this->write<logging::level::name>(stream, std::forward<Format>(fmt), std::forward<Args>(args)...);                     \
+    }                                                                                                                          \
+                                                                                                                               \
+    template <typename Stream, typename... Args>                                                                               \
+    void name(Stream &stream, fmt::format_string<Args...> fmt, Args &&...args)                                                 \
+    {                                                                                                                          \
+        fmt::string_view str = fmt;                                                                                            \
+        this->write<logging::level::name>(stream, std::string_view(str.data(), str.size()), std::forward<Args>(args)...);     \
+    }
+
+        /**
+         * @brief 按级别记录日志
+         * @details 低于 MIO_LOG_ACTIVE_LEVEL 时函数体为空, 低于运行期级别时不拷贝参数.
+         * 参数在调用前总会被求值, 需要避免时使用 MIO_LOG_DEBUG 等宏
+         */
+        MIO_LOG_LEVEL_FUNCTION(trace)
+        MIO_LOG_LEVEL_FUNCTION(debug)
+        MIO_LOG_LEVEL_FUNCTION(info)
+        MIO_LOG_LEVEL_FUNCTION(warn)
+        MIO_LOG_LEVEL_FUNCTION(error)
+        MIO_LOG_LEVEL_FUNCTION(critical)
+
+#undef MIO_LOG_LEVEL_FUNCTION
+
+        /**
+         * @brief 设置运行期级别
+         *
+         * @param level 低于该级别的日志被丢弃
+         */
+        void set_level(logging::level level)
+        {
+            level_.store(level, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 返回运行期级别
+         *
+         * @return logging::level
+         */
+        logging::level get_level() const
+        {
+            return level_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 检查该级别的日志是否会被记录
+         *
+         * @param level
+         * @return true
+         * @return false
+         */
+        bool should_log(logging::level level) const
+        {
+            return static_cast<int>(level) >= MIO_LOG_ACTIVE_LEVEL && level >= this->get_level() && level != logging::level::off;
+        }
+
+        /**
+         * @brief 设置写满时的策略
+         *
+         * @param overflow
+         */
+        void set_overflow(logging::overflow overflow)
+        {
+            overflow_.store(overflow, std::memory_order_relaxed);
         }
 
+        logging::overflow get_overflow() const
+        {
+            return overflow_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 设置结构化日志的输出格式
+         * @details 在调用 kv 时记录, 不影响已写入的日志
+         * @param format
+         */
+        void set_kv_format(logging::kv_format format)
+        {
+            kv_format_.store(format, std::memory_order_relaxed);
+        }
+
+        logging::kv_format get_kv_format() const
+        {
+            return kv_format_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief drop 策略下 丢弃的日志条数
+         *
+         * @return size_t
+         */
+        size_t dropped() const
+        {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 未处理的字节数
+         * @details grow 策略下 只在前端线程调用时准确
+         * @return size_t
+         */
         size_t size() const
         {
-            return buffer_.size();
+            size_t ret = 0;
+            for (auto buffer = head_.load(); buffer; buffer = buffer->next())
+            {
+                ret += buffer->size();
+                if (buffer == tail_)
+                    break;
+            }
+            return ret;
+        }
+
+        /**
+         * @brief 后端循环
+         * @details 每次唤醒后批量处理所有缓冲区, 直到全部为空才休眠. 空闲后先自旋 spin 时间再休眠,
+         * 前端只在后端休眠时才发出唤醒. stop 后处理完剩余消息再返回. 只有一个分片时使用,
+         * 同一时间只能有一个线程运行
+         * @param budget 每轮每个缓冲区最多处理的消息数, 避免单个线程占满后端
+         * @param spin 休眠前的自旋时间, 为 0 时立即休眠
+         */
+        static void run(size_t budget = 1024, std::chrono::nanoseconds spin = std::chrono::microseconds(50))
+        {
+            run_shard(0, budget, spin);
         }
 
-        static void run()
+        /**
+         * @brief 处理一个分片的后端循环
+         * @details set_shards(k) 后 需要 k 个线程分别以 0..k-1 运行. 每个分片由一个线程独占,
+         * 同一个 Stream 只应被一个分片的 log 使用 或自身线程安全, 否则需要每个分片使用各自的输出, 事后按记录时间合并.
+         * 归并输出只在分片内有序
+         * @param shard 分片
+         * @param budget 每轮每个缓冲区最多处理的消息数
+         * @param spin 休眠前的自旋时间
+         */
+        static void run_shard(std::size_t shard, size_t budget = 1024, std::chrono::nanoseconds spin = std::chrono::microseconds(50))
         {
+            if (shard >= shards_.load())
+                throw std::out_of_range("mio::log shard out of range");
+
+            shard_index_ = shard;
+            auto &worker = workers_[shard];
             is_run_ = true;
+
+            auto idle = std::chrono::steady_clock::time_point::max();
             while (1)
             {
-                semaphore_.acquire();
+                chrono::tsc_clock::update();
 
-                if (!is_run_)
-                    return;
+                if (drain(budget))
+                {
+                    idle = std::chrono::steady_clock::time_point::max();
+                    continue;
+                }
+
+                //归并窗口内还有消息 等待其到期
+                if (pending_)
+                    continue;
 
-                std::lock_guard lock(mutex_);
-                for (size_t i = 0; i < list_.size(); i++)
+                if (!is_run_)
                 {
-                    auto buffer = list_.front();
-                    list_.pop_front();
-                    if (buffer->size())
-                    {
-                        auto msg = buffer->front();
-                        msg->fun(msg->ptr);
-                        buffer->pop(msg);
-                        --count_;
-                        list_.push_back(buffer);
-                        break;
-                    }
-                    else
-                    {
-                        list_.push_back(buffer);
-                    }
+                    logging::flushable::flush_all(shard);
+                    return;
                 }
+
+                auto now = std::chrono::steady_clock::now();
+                if (idle == std::chrono::steady_clock::time_point::max())
+                    idle = now;
+
+                if (now - idle < spin)
+                    continue;
+
+                //休眠前写出 文件输出等缓冲的内容
+                logging::flushable::flush_all(shard);
+
+                //先发布休眠标记 再检查一次, 避免丢失唤醒
+                auto epoch = worker.epoch.load();
+                worker.sleeping = true;
+                if (!drain(budget) && !pending_ && is_run_)
+                    worker.epoch.wait(epoch);
+                worker.sleeping = false;
+                idle = std::chrono::steady_clock::time_point::max();
             }
         }
 
+        /**
+         * @brief 设置是否按记录时间归并输出
+         * @details 归并时后端对所有缓冲区的队首做 k 路归并, 不同线程的日志按记录时间输出.
+         * 晚于 当前时间 - window 的消息会等待 window 再输出, 以容纳其他线程尚未提交的更早的消息
+         * @param ordered
+         * @param window 重排窗口
+         */
+        static void set_order(bool ordered, std::chrono::nanoseconds window = std::chrono::microseconds(20))
+        {
+            window_.store(window.count(), std::memory_order_relaxed);
+            ordered_.store(ordered, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 设置后端分片数
+         * @details 需要在创建 log 之前调用, 之后以 run_shard 为每个分片启动一个线程
+         * @param shards 1 到 MAX_SHARDS
+         */
+        static void set_shards(std::size_t shards)
+        {
+            if (shards == 0 || shards > MAX_SHARDS)
+                throw std::out_of_range("mio::log shards out of range");
+            if (registry_size_.load())
+                throw std::logic_error("mio::log shards must be set before any log is created");
+            shards_ = shards;
+        }
+
+        static std::size_t shards()
+        {
+            return shards_.load();
+        }
+
+        /**
+         * @brief 所属的分片
+         *
+         * @return std::size_t
+         */
+        std::size_t shard() const
+        {
+            return shard_;
+        }
+
         static void stop()
         {
             is_run_ = false;
-            semaphore_.release();
+            for (std::size_t i = 0; i < shards_.load(); i++)
+                wake(i);
         }
     };
 }
\ No newline at end of file
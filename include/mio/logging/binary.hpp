@@ -0,0 +1,581 @@
+/**
+ * @file binary.hpp
+ * @author 然Y (inie0722@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/args.h>
+#include <fmt/compile.h>
+
+namespace mio
+{
+    /// @brief 日志
+    namespace logging
+    {
+        /**
+         * @brief 二进制日志格式
+         * @details 文件头为 "MIOLOG" 与 2 字节版本号, 之后每条记录为 u32 id, u32 size, size 字节的内容.
+         * id 为 0 的记录定义格式串: u32 格式id, u32 签名长度, 签名, u32 格式串长度, 格式串.
+         * 其余记录为一条消息: i64 记录时间(纳秒), 之后按签名依次存放的参数. 版本 1 没有记录时间. 签名每个字符表示一个参数的类型, 与 python struct 一致:
+         * ? bool, c char, b/B int8, h/H int16, i/I int32, q/Q int64, f float, d double, P 指针, s 字符串(u32 长度 + 字节)
+         */
+        namespace binary
+        {
+            inline constexpr char magic[6] = {'M', 'I', 'O', 'L', 'O', 'G'};
+            inline constexpr std::uint16_t version = 2;
+        }
+
+        /// 是否为编译期格式串 FMT_COMPILE("...") 或 "..."_cf
+        template <typename Format>
+        inline constexpr bool is_compiled_string_v = fmt::detail::is_compiled_string<std::decay_t<Format>>::value;
+
+        /**
+         * @brief 静态生存期的字符串
+         * @details 文本日志只保存指针与长度 不拷贝内容, 需要在后端处理前一直有效, 例如字符串字面量.
+         * 二进制日志与 kv 中与其他字符串一样拷贝
+         */
+        struct static_string
+        {
+            std::string_view str;
+
+            template <std::size_t Size>
+            constexpr static_string(const char (&str)[Size]) : str(str, Size - 1)
+            {
+            }
+
+            constexpr explicit static_string(std::string_view str) : str(str)
+            {
+            }
+
+            constexpr operator std::string_view() const
+            {
+                return str;
+            }
+        };
+
+        namespace detail
+        {
+            template <typename T>
+            inline constexpr bool is_binary_string_v = std::is_same_v<T, const char *> || std::is_same_v<T, char *> ||
+                                                      std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> ||
+                                                      std::is_same_v<T, static_string>;
+
+            /// 参数类型对应的签名字符
+            template <typename T>
+            constexpr char binary_code()
+            {
+                if constexpr (std::is_same_v<T, bool>)
+                    return '?';
+                else if constexpr (std::is_same_v<T, char>)
+                    return 'c';
+                else if constexpr (std::is_integral_v<T>)
+                {
+                    constexpr char code[] = {'b', 'h', 'i', 'q'};
+                    constexpr std::size_t index = sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1
+                                                            : sizeof(T) == 4   ? 2
+                                                                               : 3;
+                    static_assert(sizeof(T) <= 8, "unsupported integer in binary log");
+                    return std::is_signed_v<T> ? code[index] : code[index] - 'a' + 'A';
+                }
+                else if constexpr (std::is_enum_v<T>)
+                    return binary_code<std::underlying_type_t<T>>();
+                else if constexpr (std::is_same_v<T, float>)
+                    return 'f';
+                else if constexpr (std::is_same_v<T, double>)
+                    return 'd';
+                else if constexpr (is_binary_string_v<T>)
+                    return 's';
+                else if constexpr (std::is_pointer_v<T>)
+                    return 'P';
+                else
+                {
+                    static_assert(!sizeof(T), "unsupported argument type in binary log, format it to a string first");
+                    return 0;
+                }
+            }
+
+            template <typename... Args>
+            struct binary_signature
+            {
+                static constexpr char value[] = {binary_code<std::decay_t<Args>>()..., '\0'};
+            };
+
+            template <typename T>
+            std::string_view binary_string(const T &arg)
+            {
+                if constexpr (std::is_pointer_v<T>)
+                    return arg ? std::string_view(arg) : std::string_view();
+                else
+                    return std::string_view(arg);
+            }
+
+            template <typename T>
+            std::size_t binary_size(const T &arg)
+            {
+                if constexpr (is_binary_string_v<T>)
+                    return sizeof(std::uint32_t) + binary_string(arg).size();
+                else if constexpr (std::is_pointer_v<T>)
+                    return sizeof(std::uint64_t);
+                else
+                    return sizeof(T);
+            }
+
+            template <typename T>
+            char *binary_write(char *out, const T &arg)
+            {
+                if constexpr (is_binary_string_v<T>)
+                {
+                    auto str = binary_string(arg);
+                    std::uint32_t size = str.size();
+                    std::memcpy(out, &size, sizeof(size));
+                    std::memcpy(out + sizeof(size), str.data(), size);
+                    return out + sizeof(size) + size;
+                }
+                else if constexpr (std::is_pointer_v<T>)
+                {
+                    auto value = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(arg));
+                    std::memcpy(out, &value, sizeof(value));
+                    return out + sizeof(value);
+                }
+                else
+                {
+                    std::memcpy(out, &arg, sizeof(T));
+                    return out + sizeof(T);
+                }
+            }
+        }
+
+        /**
+         * @brief 格式串注册表
+         * @details 每个 (格式串, 签名) 对应一个进程内唯一的 id, 从 1 开始
+         */
+        class format_registry
+        {
+        public:
+            struct entry
+            {
+                std::string format;
+                std::string signature;
+            };
+
+        private:
+            inline static std::mutex mutex_;
+            inline static std::deque<entry> entries_;
+            inline static std::map<std::pair<std::string_view, std::string_view>, std::uint32_t> index_;
+
+        public:
+            /**
+             * @brief 注册格式串
+             *
+             * @param format
+             * @param signature
+             * @return std::uint32_t id
+             */
+            static std::uint32_t add(std::string_view format, std::string_view signature)
+            {
+                std::lock_guard lock(mutex_);
+                auto it = index_.find({format, signature});
+                if (it != index_.end())
+                    return it->second;
+
+                auto &ret = entries_.emplace_back(entry{std::string(format), std::string(signature)});
+                std::uint32_t id = entries_.size();
+                index_.emplace(std::pair<std::string_view, std::string_view>(ret.format, ret.signature), id);
+                return id;
+            }
+
+            /**
+             * @brief 获取 id 对应的格式串
+             * @details 返回的引用一直有效
+             * @param id
+             * @return const entry&
+             */
+            static const entry &get(std::uint32_t id)
+            {
+                std::lock_guard lock(mutex_);
+                return entries_.at(id - 1);
+            }
+        };
+
+        /**
+         * @brief 获取格式串 id
+         * @details 编译期格式串每个调用点只注册一次, 之后直接返回静态 id.
+         * 运行期格式串 每个参数类型组合在每个线程缓存最近一次的格式串, 命中时只比较内容
+         * @tparam Args 参数类型
+         * @tparam Format 格式串类型
+         * @param format
+         * @return std::uint32_t
+         */
+        template <typename... Args, typename Format>
+        std::uint32_t format_id(const Format &format)
+        {
+            if constexpr (is_compiled_string_v<Format>)
+            {
+                static const std::uint32_t id = [&]()
+                {
+                    auto str = fmt::string_view(format);
+                    return format_registry::add(std::string_view(str.data(), str.size()), detail::binary_signature<Args...>::value);
+                }();
+                return id;
+            }
+            else
+            {
+                thread_local std::string_view last;
+                thread_local std::uint32_t last_id = 0;
+
+                std::string_view str(format);
+                if (last_id && last == str)
+                    return last_id;
+
+                last_id = format_registry::add(str, detail::binary_signature<Args...>::value);
+                last = format_registry::get(last_id).format;
+                return last_id;
+            }
+        }
+
+        /**
+         * @brief 参数编码后的大小
+         *
+         * @tparam Args
+         * @param args
+         * @return std::size_t
+         */
+        template <typename... Args>
+        std::size_t binary_size(const Args &...args)
+        {
+            return (std::size_t(0) + ... + detail::binary_size<std::decay_t<const Args &>>(args));
+        }
+
+        /**
+         * @brief 按签名编码参数
+         *
+         * @tparam Args
+         * @param out 至少 binary_size(args...) 字节
+         * @param args
+         * @return char* 写入结束位置
+         */
+        template <typename... Args>
+        char *binary_encode(char *out, const Args &...args)
+        {
+            ((out = detail::binary_write<std::decay_t<const Args &>>(out, args)), ...);
+            return out;
+        }
+
+        /**
+         * @brief 格式串的定义记录
+         *
+         * @param id 格式串id
+         * @return std::string 可直接写出的 id 为 0 的记录
+         */
+        inline std::string binary_definition(std::uint32_t id)
+        {
+            auto &entry = format_registry::get(id);
+
+            std::string ret;
+            auto append_u32 = [&](std::uint32_t value)
+            { ret.append(reinterpret_cast<const char *>(&value), sizeof(value)); };
+
+            append_u32(0);
+            append_u32(sizeof(std::uint32_t) * 3 + entry.signature.size() + entry.format.size());
+            append_u32(id);
+            append_u32(entry.signature.size());
+            ret += entry.signature;
+            append_u32(entry.format.size());
+            ret += entry.format;
+            return ret;
+        }
+
+        /**
+         * @brief 二进制日志输出
+         * @details 作为 mio::log 的 Stream 时, 前端只拷贝参数的原始字节, 后端不格式化, 直接写出 格式串id 与参数.
+         * 每个格式串第一次出现时先写出其定义. 之后可用 binary_decoder 离线渲染
+         * @tparam Output 需要 write(const char *, size) 例如 std::ofstream
+         */
+        template <typename Output>
+        class binary_sink
+        {
+        private:
+            Output &output_;
+            std::vector<bool> defined_;
+
+            void write_u32(std::uint32_t value)
+            {
+                output_.write(reinterpret_cast<const char *>(&value), sizeof(value));
+            }
+
+            void define(std::uint32_t id)
+            {
+                if (id < defined_.size() && defined_[id])
+                    return;
+
+                if (id >= defined_.size())
+                    defined_.resize(id + 1);
+                defined_[id] = true;
+
+                auto record = binary_definition(id);
+                output_.write(record.data(), record.size());
+            }
+
+        public:
+            binary_sink(Output &output)
+                : output_(output)
+            {
+                output_.write(binary::magic, sizeof(binary::magic));
+                output_.write(reinterpret_cast<const char *>(&binary::version), sizeof(binary::version));
+            }
+
+            /**
+             * @brief 写出一条消息
+             *
+             * @param id 格式串id
+             * @param time 记录时间
+             * @param data 编码后的参数
+             * @param size
+             */
+            void write(std::uint32_t id, std::chrono::nanoseconds time, const char *data, std::size_t size)
+            {
+                std::int64_t count = time.count();
+
+                this->define(id);
+                write_u32(id);
+                write_u32(sizeof(count) + size);
+                output_.write(reinterpret_cast<const char *>(&count), sizeof(count));
+                output_.write(data, size);
+            }
+        };
+
+        template <typename T>
+        inline constexpr bool is_binary_sink_v = false;
+
+        template <typename Output>
+        inline constexpr bool is_binary_sink_v<binary_sink<Output>> = true;
+
+        /**
+         * @brief 二进制日志解码
+         * @details 可离线解码 binary_sink 写出的文件, 也可按需解码内存中的数据
+         */
+        class binary_decoder
+        {
+        private:
+            std::vector<format_registry::entry> formats_;
+            std::vector<bool> defined_;
+            std::string buffer_;
+            bool has_header_ = false;
+            bool has_time_ = true;
+
+            template <typename T>
+            static T read(const char *&data, const char *end)
+            {
+                if (static_cast<std::size_t>(end - data) < sizeof(T))
+                    throw std::runtime_error("bad binary log");
+
+                T ret;
+                std::memcpy(&ret, data, sizeof(T));
+                data += sizeof(T);
+                return ret;
+            }
+
+            static std::string_view read_string(const char *&data, const char *end)
+            {
+                auto size = read<std::uint32_t>(data, end);
+                if (static_cast<std::size_t>(end - data) < size)
+                    throw std::runtime_error("bad binary log");
+
+                std::string_view ret(data, size);
+                data += size;
+                return ret;
+            }
+
+            std::string render(std::uint32_t id, const char *data, const char *end) const
+            {
+                if (id >= defined_.size() || !defined_[id])
+                    throw std::runtime_error("undefined format id in binary log");
+
+                auto &entry = formats_[id];
+                fmt::dynamic_format_arg_store<fmt::format_context> store;
+                for (auto code : entry.signature)
+                {
+                    switch (code)
+                    {
+                    case '?':
+                        store.push_back(read<bool>(data, end));
+                        break;
+                    case 'c':
+                        store.push_back(read<char>(data, end));
+                        break;
+                    case 'b':
+                        store.push_back(read<std::int8_t>(data, end));
+                        break;
+                    case 'B':
+                        store.push_back(read<std::uint8_t>(data, end));
+                        break;
+                    case 'h':
+                        store.push_back(read<std::int16_t>(data, end));
+                        break;
+                    case 'H':
+                        store.push_back(read<std::uint16_t>(data, end));
+                        break;
+                    case 'i':
+                        store.push_back(read<std::int32_t>(data, end));
+                        break;
+                    case 'I':
+                        store.push_back(read<std::uint32_t>(data, end));
+                        break;
+                    case 'q':
+                        store.push_back(read<std::int64_t>(data, end));
+                        break;
+                    case 'Q':
+                        store.push_back(read<std::uint64_t>(data, end));
+                        break;
+                    case 'f':
+                        store.push_back(read<float>(data, end));
+                        break;
+                    case 'd':
+                        store.push_back(read<double>(data, end));
+                        break;
+                    case 'P':
+                        store.push_back(reinterpret_cast<const void *>(static_cast<std::uintptr_t>(read<std::uint64_t>(data, end))));
+                        break;
+                    case 's':
+                        store.push_back(read_string(data, end));
+                        break;
+                    default:
+                        throw std::runtime_error("bad signature in binary log");
+                    }
+                }
+                return fmt::vformat(entry.format, store);
+            }
+
+        public:
+            /**
+             * @brief 解码一段数据
+             * @details 可分多次传入, 不完整的记录会保留到下一次
+             * @tparam Callback void(std::string_view) 每条消息渲染后的文本,
+             * 或 void(std::chrono::nanoseconds, std::string_view) 同时接收记录时间
+             * @param data
+             * @param size
+             * @param callback
+             * @return std::size_t 解码出的消息数
+             */
+            template <typename Callback>
+            std::size_t decode(const char *data, std::size_t size, Callback &&callback)
+            {
+                buffer_.append(data, size);
+
+                const char *begin = buffer_.data();
+                const char *end = begin + buffer_.size();
+
+                if (!has_header_)
+                {
+                    constexpr auto header_size = sizeof(binary::magic) + sizeof(binary::version);
+                    if (buffer_.size() < header_size)
+                        return 0;
+
+                    if (std::memcmp(begin, binary::magic, sizeof(binary::magic)))
+                        throw std::runtime_error("bad binary log magic");
+
+                    std::uint16_t ver;
+                    std::memcpy(&ver, begin + sizeof(binary::magic), sizeof(ver));
+                    if (ver < 1 || ver > binary::version)
+                        throw std::runtime_error("unsupported binary log version");
+                    has_time_ = ver >= 2;
+
+                    begin += header_size;
+                    has_header_ = true;
+                }
+
+                std::size_t count = 0;
+                while (static_cast<std::size_t>(end - begin) >= sizeof(std::uint32_t) * 2)
+                {
+                    std::uint32_t id, length;
+                    std::memcpy(&id, begin, sizeof(id));
+                    std::memcpy(&length, begin + sizeof(id), sizeof(length));
+                    if (static_cast<std::size_t>(end - begin) < sizeof(std::uint32_t) * 2 + length)
+                        break;
+
+                    const char *record = begin + sizeof(std::uint32_t) * 2;
+                    const char *record_end = record + length;
+                    if (id == 0)
+                    {
+                        auto format_id = read<std::uint32_t>(record, record_end);
+                        auto signature = read_string(record, record_end);
+                        auto format = read_string(record, record_end);
+                        if (format_id >= formats_.size())
+                        {
+                            formats_.resize(format_id + 1);
+                            defined_.resize(format_id + 1);
+                        }
+                        formats_[format_id] = {std::string(format), std::string(signature)};
+                        defined_[format_id] = true;
+                    }
+                    else
+                    {
+                        std::chrono::nanoseconds time(has_time_ ? read<std::int64_t>(record, record_end) : 0);
+                        auto str = this->render(id, record, record_end);
+
+                        if constexpr (std::is_invocable_v<Callback, std::chrono::nanoseconds, std::string_view>)
+                            callback(time, std::string_view(str));
+                        else
+                            callback(std::string_view(str));
+                        count++;
+                    }
+                    begin = record_end;
+                }
+
+                buffer_.erase(0, begin - buffer_.data());
+                return count;
+            }
+
+            /**
+             * @brief 解码整个流
+             *
+             * @tparam Stream 需要 read(char *, size) 与 gcount()
+             * @tparam Callback 同上
+             * @param stream
+             * @param callback
+             * @return std::size_t 解码出的消息数
+             */
+            template <typename Stream, typename Callback>
+            std::size_t decode(Stream &stream, Callback &&callback)
+            {
+                char buf[65536];
+                std::size_t count = 0;
+                while (stream.read(buf, sizeof(buf)), stream.gcount() > 0)
+                {
+                    count += this->decode(buf, stream.gcount(), callback);
+                }
+                return count;
+            }
+        };
+    } // namespace logging
+} // namespace mio
+
+template <>
+struct fmt::formatter<mio::logging::static_string> : fmt::formatter<std::string_view>
+{
+    template <typename FormatContext>
+    auto format(const mio::logging::static_string &str, FormatContext &ctx) const
+    {
+        return fmt::formatter<std::string_view>::format(str.str, ctx);
+    }
+};
@@ -0,0 +1,181 @@
+/**
+ * @file kv.hpp
+ * @author 然Y (inie0722@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+
+#include <fmt/format.h>
+
+#include <mio/logging/binary.hpp>
+
+namespace mio
+{
+    namespace logging
+    {
+        /// 结构化日志的输出格式
+        enum class kv_format : std::uint8_t
+        {
+            /// {"event":"order","id":1,"px":2.5}
+            json,
+            /// event=order id=1 px=2.5
+            logfmt,
+        };
+
+        namespace detail
+        {
+            /// 键需要是字符串字面量 只保存指针
+            template <typename T>
+            inline constexpr bool is_kv_key_v = std::is_array_v<std::remove_reference_t<T>> &&
+                                               std::is_same_v<std::remove_cv_t<std::remove_extent_t<std::remove_reference_t<T>>>, char>;
+
+            inline void kv_escape_json(fmt::memory_buffer &out, std::string_view str)
+            {
+                out.push_back('"');
+                for (char c : str)
+                {
+                    switch (c)
+                    {
+                    case '"':
+                        out.append(std::string_view("\\\""));
+                        break;
+                    case '\\':
+                        out.append(std::string_view("\\\\"));
+                        break;
+                    case '\n':
+                        out.append(std::string_view("\\n"));
+                        break;
+                    case '\r':
+                        out.append(std::string_view("\\r"));
+                        break;
+                    case '\t':
+                        out.append(std::string_view("\\t"));
+                        break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20)
+                            fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<unsigned>(c));
+                        else
+                            out.push_back(c);
+                    }
+                }
+                out.push_back('"');
+            }
+
+            //logfmt 只在需要时加引号
+            inline void kv_escape_logfmt(fmt::memory_buffer &out, std::string_view str)
+            {
+                bool quote = str.empty();
+                for (char c : str)
+                {
+                    if (c == ' ' || c == '=' || c == '"' || static_cast<unsigned char>(c) < 0x20)
+                    {
+                        quote = true;
+                        break;
+                    }
+                }
+
+                if (quote)
+                    kv_escape_json(out, str);
+                else
+                    out.append(str);
+            }
+
+            inline void kv_string(fmt::memory_buffer &out, kv_format format, std::string_view str)
+            {
+                if (format == kv_format::json)
+                    kv_escape_json(out, str);
+                else
+                    kv_escape_logfmt(out, str);
+            }
+
+            //按 binary_encode 的布局读出一个值并输出
+            template <typename T>
+            const char *kv_value(fmt::memory_buffer &out, kv_format format, const char *data)
+            {
+                auto it = std::back_inserter(out);
+                if constexpr (is_binary_string_v<T>)
+                {
+                    std::uint32_t size;
+                    std::memcpy(&size, data, sizeof(size));
+                    kv_string(out, format, std::string_view(data + sizeof(size), size));
+                    return data + sizeof(size) + size;
+                }
+                else if constexpr (std::is_pointer_v<T>)
+                {
+                    std::uint64_t value;
+                    std::memcpy(&value, data, sizeof(value));
+                    kv_string(out, format, fmt::format("{:#x}", value));
+                    return data + sizeof(value);
+                }
+                else
+                {
+                    T value;
+                    std::memcpy(&value, data, sizeof(T));
+                    if constexpr (std::is_same_v<T, bool>)
+                        out.append(std::string_view(value ? "true" : "false"));
+                    else if constexpr (std::is_same_v<T, char>)
+                        kv_string(out, format, std::string_view(&value, 1));
+                    else if constexpr (std::is_enum_v<T>)
+                        fmt::format_to(it, "{}", static_cast<std::underlying_type_t<T>>(value));
+                    else if constexpr (std::is_floating_point_v<T>)
+                    {
+                        //json 没有 nan 与 inf
+                        if (format == kv_format::json && !std::isfinite(value))
+                            out.append(std::string_view("null"));
+                        else
+                            fmt::format_to(it, "{}", value);
+                    }
+                    else
+                        fmt::format_to(it, "{}", value);
+                    return data + sizeof(T);
+                }
+            }
+        } // namespace detail
+
+        /**
+         * @brief 输出一条结构化日志
+         * @details 值为 binary_encode(values...) 的结果, 由后端调用. 不附加换行
+         * @tparam Values 值的类型 与编码时一致
+         * @param out
+         * @param format 输出格式
+         * @param event 事件名
+         * @param keys sizeof...(Values) 个键
+         * @param data 编码后的值
+         */
+        template <typename... Values>
+        void kv_render(fmt::memory_buffer &out, kv_format format, std::string_view event, const char *const *keys, const char *data)
+        {
+            std::size_t index = 0;
+            if (format == kv_format::json)
+            {
+                out.append(std::string_view("{\"event\":"));
+                detail::kv_escape_json(out, event);
+                ((out.push_back(','), detail::kv_escape_json(out, keys[index++]), out.push_back(':'),
+                  data = detail::kv_value<std::decay_t<Values>>(out, format, data)),
+                 ...);
+                out.push_back('}');
+            }
+            else
+            {
+                out.append(std::string_view("event="));
+                detail::kv_escape_logfmt(out, event);
+                ((out.push_back(' '), detail::kv_escape_logfmt(out, keys[index++]), out.push_back('='),
+                  data = detail::kv_value<std::decay_t<Values>>(out, format, data)),
+                 ...);
+            }
+        }
+    } // namespace logging
+} // namespace mio
@@ -0,0 +1,303 @@
+/**
+ * @file shm.hpp
+ * @author 然Y (inie0722@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <mio/chrono.hpp>
+#include <mio/interprocess.hpp>
+#include <mio/logging/binary.hpp>
+
+namespace mio
+{
+    namespace logging
+    {
+        namespace detail
+        {
+            /// 缓冲区中的消息头 shm 恢复时按此布局读取
+            struct message
+            {
+                void (*fun)(void *ptr, std::chrono::nanoseconds time);
+                void *ptr;
+                std::uint32_t size;
+                std::uint32_t flags;
+                /// 前端记录时的 TSC, 由后端换算为时间
+                std::uint64_t tsc;
+            };
+
+            /// 消息为二进制记录 参数布局为 Stream*, u32 格式id, u32 大小, 编码后的参数
+            inline constexpr std::uint32_t message_binary = 1;
+
+            /// 共享内存中的日志注册表容量
+            inline constexpr std::size_t SHM_REGISTRY_SIZE = 4096;
+
+            /// 段头在共享内存中的名字
+            inline constexpr const char *SHM_HEADER_NAME = "mio::logging::shm_header";
+
+            /**
+             * @brief 共享内存段头
+             * @details 地址均为写入进程中的地址, 恢复时按 base 换算为本进程的地址.
+             * 缓冲区布局: size_t 可写位置, size_t 可读位置, 之后 data_offset 处为 buffer_size 字节的环形数据
+             */
+            struct shm_header
+            {
+                char magic[8] = {'M', 'I', 'O', 'S', 'H', 'M'};
+                std::uint32_t version = 1;
+                std::uint32_t message_size = sizeof(message);
+                std::uint64_t base = 0;
+                std::atomic<std::uint64_t> buffer_size = 0;
+                std::atomic<std::uint64_t> data_offset = 0;
+                std::uint64_t definitions = 0;
+                std::uint64_t definitions_capacity = 0;
+                std::atomic<std::uint64_t> definitions_size = 0;
+                std::atomic<std::uint64_t> buffers[SHM_REGISTRY_SIZE] = {};
+            };
+        } // namespace detail
+
+        /**
+         * @brief 日志共享内存段
+         * @details 以此构造的 mio::log 把缓冲区放在共享内存中, 二进制记录用到的格式串定义也写入共享内存.
+         * 进程崩溃后 可由 shm_recover 恢复尚未写出的二进制记录. 正常析构时删除共享内存, 析构前需先析构使用它的 log
+         */
+        class shm_segment
+        {
+        private:
+            inline static constexpr std::size_t PUBLISHED_SIZE = 65536;
+
+            std::string name_;
+            mio::interprocess::managed_shared_memory segment_;
+            detail::shm_header *header_;
+            char *definitions_;
+
+            std::mutex mutex_;
+            std::unique_ptr<std::atomic<bool>[]> published_;
+            std::vector<bool> published_large_;
+
+        public:
+            /**
+             * @brief 创建共享内存段
+             * @details 同名共享内存已存在时抛出异常, 可能是崩溃留下的, 需要先恢复
+             * @param name 共享内存名
+             * @param size 共享内存大小 需要容纳所有缓冲区
+             * @param definitions_size 格式串定义区大小
+             */
+            shm_segment(std::string name, std::size_t size, std::size_t definitions_size = 1 << 20)
+                : name_(std::move(name)), segment_(boost::interprocess::create_only, name_.c_str(), size),
+                  published_(new std::atomic<bool>[PUBLISHED_SIZE]())
+            {
+                header_ = segment_.construct<detail::shm_header>(detail::SHM_HEADER_NAME)();
+                definitions_ = static_cast<char *>(segment_.allocate(definitions_size));
+
+                header_->base = reinterpret_cast<std::uintptr_t>(segment_.get_address());
+                header_->definitions = reinterpret_cast<std::uintptr_t>(definitions_);
+                header_->definitions_capacity = definitions_size;
+            }
+
+            shm_segment(const shm_segment &) = delete;
+            shm_segment &operator=(const shm_segment &) = delete;
+
+            ~shm_segment()
+            {
+                boost::interprocess::shared_memory_object::remove(name_.c_str());
+            }
+
+            /**
+             * @brief 分配一个缓冲区 并登记到注册表
+             *
+             * @param size 缓冲区对象大小
+             * @param buffer_size 环形数据大小 同一共享内存段中需要一致
+             * @param data_offset 环形数据在缓冲区对象中的偏移
+             * @return void*
+             */
+            void *allocate(std::size_t size, std::size_t buffer_size, std::size_t data_offset)
+            {
+                std::uint64_t expected = 0;
+                if (!header_->buffer_size.compare_exchange_strong(expected, buffer_size) && expected != buffer_size)
+                    throw std::runtime_error("mio::logging::shm_segment buffer size mismatch");
+                header_->data_offset = data_offset;
+
+                void *ret = segment_.allocate_aligned(size, 64);
+                for (auto &slot : header_->buffers)
+                {
+                    std::uint64_t empty = 0;
+                    if (slot.compare_exchange_strong(empty, reinterpret_cast<std::uintptr_t>(ret)))
+                        return ret;
+                }
+
+                segment_.deallocate(ret);
+                throw std::runtime_error("mio::logging::shm_segment registry is full");
+            }
+
+            /**
+             * @brief 注销并释放缓冲区
+             *
+             * @param ptr
+             */
+            void deallocate(void *ptr)
+            {
+                for (auto &slot : header_->buffers)
+                {
+                    std::uint64_t expected = reinterpret_cast<std::uintptr_t>(ptr);
+                    if (slot.compare_exchange_strong(expected, 0))
+                        break;
+                }
+                segment_.deallocate(ptr);
+            }
+
+            /**
+             * @brief 把格式串定义写入共享内存
+             * @details 每个 id 只写一次, 已写过时只有一次原子读
+             * @param id 格式串id
+             */
+            void define(std::uint32_t id)
+            {
+                if (id < PUBLISHED_SIZE && published_[id].load(std::memory_order_acquire))
+                    return;
+
+                std::lock_guard lock(mutex_);
+                if (id < PUBLISHED_SIZE ? published_[id].load() : id < published_large_.size() && published_large_[id])
+                    return;
+
+                auto record = binary_definition(id);
+                auto size = header_->definitions_size.load();
+                if (size + record.size() > header_->definitions_capacity)
+                    throw std::runtime_error("mio::logging::shm_segment definitions are full");
+
+                std::memcpy(definitions_ + size, record.data(), record.size());
+                header_->definitions_size.store(size + record.size(), std::memory_order_release);
+
+                if (id < PUBLISHED_SIZE)
+                    published_[id].store(true, std::memory_order_release);
+                else
+                {
+                    if (id >= published_large_.size())
+                        published_large_.resize(id + 1);
+                    published_large_[id] = true;
+                }
+            }
+
+            const std::string &name() const
+            {
+                return name_;
+            }
+        };
+
+        /**
+         * @brief 从崩溃进程留下的共享内存中恢复未写出的二进制记录
+         * @details 按记录时间排序后 以 binary_sink 的格式写出, 可用 binary_decoder 解码.
+         * 后端崩溃时正在处理的一批记录可能已经写出过, 会重复出现. 参数过大而放在堆上的记录无法恢复
+         * @tparam Output 需要 write(const char *, size) 例如 std::ofstream
+         * @param name 共享内存名
+         * @param output
+         * @return std::size_t 恢复的记录数
+         */
+        template <typename Output>
+        std::size_t shm_recover(const std::string &name, Output &output)
+        {
+            mio::interprocess::managed_shared_memory segment(boost::interprocess::open_read_only, name.c_str());
+
+            auto header = segment.find<detail::shm_header>(detail::SHM_HEADER_NAME).first;
+            if (!header || std::memcmp(header->magic, "MIOSHM", 6) || header->version != 1 || header->message_size != sizeof(detail::message))
+                throw std::runtime_error("bad mio::logging::shm_segment " + name);
+
+            auto base = static_cast<const char *>(segment.get_address());
+            auto segment_size = segment.get_size();
+            auto translate = [&](std::uint64_t addr, std::size_t size) -> const char *
+            {
+                if (addr < header->base || addr + size > header->base + segment_size)
+                    return nullptr;
+                return base + (addr - header->base);
+            };
+
+            std::uint64_t buffer_size = header->buffer_size;
+            std::uint64_t data_offset = header->data_offset;
+
+            struct record
+            {
+                std::uint64_t tsc;
+                std::uint32_t id;
+                const char *data;
+                std::uint32_t size;
+            };
+            std::vector<record> records;
+
+            for (auto &slot : header->buffers)
+            {
+                auto buffer = translate(slot.load(), data_offset + buffer_size);
+                if (!buffer)
+                    continue;
+
+                std::size_t writable_limit, readable_limit;
+                std::memcpy(&writable_limit, buffer, sizeof(writable_limit));
+                std::memcpy(&readable_limit, buffer + sizeof(writable_limit), sizeof(readable_limit));
+
+                auto data = buffer + data_offset;
+                auto data_addr = slot.load() + data_offset;
+                while (readable_limit < writable_limit)
+                {
+                    detail::message msg;
+                    std::memcpy(&msg, data + readable_limit % buffer_size, sizeof(msg));
+                    if (!msg.size)
+                        break;
+                    readable_limit += msg.size;
+
+                    //参数需要在环形数据中
+                    auto addr = reinterpret_cast<std::uintptr_t>(msg.ptr);
+                    constexpr auto head_size = sizeof(void *) + sizeof(std::uint32_t) * 2;
+                    if (!(msg.flags & detail::message_binary) || addr < data_addr || addr + head_size > data_addr + buffer_size)
+                        continue;
+
+                    auto ptr = data + (addr - data_addr);
+                    std::uint32_t id, size;
+                    std::memcpy(&id, ptr + sizeof(void *), sizeof(id));
+                    std::memcpy(&size, ptr + sizeof(void *) + sizeof(id), sizeof(size));
+                    if (addr + head_size + size > data_addr + buffer_size)
+                        continue;
+
+                    records.push_back({msg.tsc, id, ptr + head_size, size});
+                }
+            }
+
+            std::stable_sort(records.begin(), records.end(), [](const record &a, const record &b)
+                             { return a.tsc < b.tsc; });
+
+            output.write(binary::magic, sizeof(binary::magic));
+            output.write(reinterpret_cast<const char *>(&binary::version), sizeof(binary::version));
+
+            auto definitions = translate(header->definitions, header->definitions_size);
+            if (definitions)
+                output.write(definitions, header->definitions_size);
+
+            for (auto &i : records)
+            {
+                std::int64_t time = mio::chrono::tsc_clock::to_time(i.tsc).count();
+                std::uint32_t size = sizeof(time) + i.size;
+                output.write(reinterpret_cast<const char *>(&i.id), sizeof(i.id));
+                output.write(reinterpret_cast<const char *>(&size), sizeof(size));
+                output.write(reinterpret_cast<const char *>(&time), sizeof(time));
+                output.write(i.data, i.size);
+            }
+
+            return records.size();
+        }
+    } // namespace logging
+} // namespace mio
@@ -0,0 +1,386 @@
+/**
+ * @file sink.hpp
+ * @author 然Y (inie0722@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <limits.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+extern char **environ;
+
+namespace mio
+{
+    namespace logging
+    {
+        /**
+         * @brief 需要后端定期写出的输出
+         * @details 构造时注册, 后端线程空闲休眠前与退出时 写出自己写入过的输出
+         */
+        class flushable
+        {
+        private:
+            inline static std::mutex mutex_;
+            inline static std::vector<flushable *> list_;
+
+            bool attached_ = true;
+            /// 最近写入的后端分片
+            std::atomic<std::size_t> owner_ = 0;
+
+        protected:
+            //派生类析构时先注销, 避免后端在析构过程中调用 flush
+            void detach()
+            {
+                std::lock_guard lock(mutex_);
+                if (attached_)
+                {
+                    std::erase(list_, this);
+                    attached_ = false;
+                }
+            }
+
+        public:
+            flushable()
+            {
+                std::lock_guard lock(mutex_);
+                list_.push_back(this);
+            }
+
+            flushable(const flushable &) = delete;
+            flushable &operator=(const flushable &) = delete;
+
+            virtual ~flushable()
+            {
+                this->detach();
+            }
+
+            /// 写出缓冲的内容
+            virtual void flush() = 0;
+
+            /// 由写入的后端线程调用 记录所属分片
+            void own(std::size_t shard)
+            {
+                if (owner_.load(std::memory_order_relaxed) != shard)
+                    owner_.store(shard, std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief 写出属于该分片的输出的缓冲
+             *
+             * @param shard 后端分片
+             */
+            static void flush_all(std::size_t shard = 0)
+            {
+                std::lock_guard lock(mutex_);
+                for (auto sink : list_)
+                {
+                    if (sink->owner_.load(std::memory_order_relaxed) == shard)
+                        sink->flush();
+                }
+            }
+        };
+
+        namespace detail
+        {
+            //后台压缩轮换出的文件 每个文件启动一次压缩命令
+            class compressor
+            {
+            private:
+                std::string command_;
+                std::mutex mutex_;
+                std::condition_variable cv_;
+                std::deque<std::string> queue_;
+                bool is_run_ = true;
+                std::thread thread_;
+
+                void run()
+                {
+                    std::unique_lock lock(mutex_);
+                    while (1)
+                    {
+                        cv_.wait(lock, [&]()
+                                 { return !queue_.empty() || !is_run_; });
+                        if (queue_.empty())
+                            return;
+
+                        auto path = std::move(queue_.front());
+                        queue_.pop_front();
+
+                        lock.unlock();
+                        compress(path);
+                        lock.lock();
+                    }
+                }
+
+                void compress(std::string &path)
+                {
+                    char *argv[] = {command_.data(), path.data(), nullptr};
+
+                    pid_t pid;
+                    if (posix_spawnp(&pid, command_.c_str(), nullptr, nullptr, argv, environ) == 0)
+                        waitpid(pid, nullptr, 0);
+                }
+
+            public:
+                compressor(std::string command)
+                    : command_(std::move(command)), thread_([this]()
+                                                            { this->run(); })
+                {
+                }
+
+                ~compressor()
+                {
+                    {
+                        std::lock_guard lock(mutex_);
+                        is_run_ = false;
+                    }
+                    cv_.notify_one();
+                    thread_.join();
+                }
+
+                void push(std::string path)
+                {
+                    {
+                        std::lock_guard lock(mutex_);
+                        queue_.push_back(std::move(path));
+                    }
+                    cv_.notify_one();
+                }
+            };
+        } // namespace detail
+
+        /// file_sink 选项
+        struct file_options
+        {
+            /// 缓冲达到该大小时写出
+            std::size_t buffer_size = 1 << 20;
+            /// 每个缓冲块的大小 写出时以 writev 一次提交所有块
+            std::size_t chunk_size = 64 << 10;
+            /// 文件达到该大小时轮换 0 为不按大小轮换
+            std::size_t rotate_size = 0;
+            /// 按该间隔轮换 0 为不按时间轮换
+            std::chrono::nanoseconds rotate_interval = std::chrono::nanoseconds(0);
+            /// 每行前加上记录时间
+            bool time = true;
+            /// 压缩轮换出的文件 为空时不压缩, 例如 "gzip" "zstd"
+            std::string compress;
+        };
+
+        /**
+         * @brief 文件输出
+         * @details 作为 mio::log 的 Stream 时 由后端写入: 格式化结果先累积到缓冲块, 满 buffer_size 或后端空闲时
+         * 以 writev 写出. 轮换在后端完成, 不阻塞前端; 轮换出的文件名为 path.年月日-时分秒.序号, 可在后台压缩
+         */
+        class file_sink : public flushable
+        {
+        private:
+            std::string path_;
+            file_options options_;
+            int fd_ = -1;
+
+            std::vector<std::unique_ptr<char[]>> chunks_;
+            std::vector<iovec> iov_;
+            std::size_t buffered_ = 0;
+
+            std::size_t file_size_ = 0;
+            std::chrono::nanoseconds next_rotate_ = std::chrono::nanoseconds::max();
+            std::size_t sequence_ = 0;
+
+            std::int64_t second_ = -1;
+            char second_str_[32];
+            std::size_t second_size_ = 0;
+
+            std::unique_ptr<detail::compressor> compressor_;
+
+            void open()
+            {
+                fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+                if (fd_ < 0)
+                    throw std::system_error(errno, std::generic_category(), "can not open " + path_);
+
+                struct stat st;
+                file_size_ = fstat(fd_, &st) == 0 ? st.st_size : 0;
+            }
+
+            //追加到缓冲块 当前块写满后换下一块
+            void append(const char *data, std::size_t size)
+            {
+                while (size)
+                {
+                    if (iov_.empty() || iov_.back().iov_len == options_.chunk_size)
+                    {
+                        if (iov_.size() == chunks_.size())
+                            chunks_.emplace_back(new char[options_.chunk_size]);
+                        iov_.push_back({chunks_[iov_.size()].get(), 0});
+                    }
+
+                    auto &iov = iov_.back();
+                    auto n = std::min(size, options_.chunk_size - iov.iov_len);
+                    std::memcpy(static_cast<char *>(iov.iov_base) + iov.iov_len, data, n);
+                    iov.iov_len += n;
+                    buffered_ += n;
+                    data += n;
+                    size -= n;
+                }
+            }
+
+            //时间前缀 秒以上的部分每秒只格式化一次
+            void append_time(std::chrono::nanoseconds time)
+            {
+                auto second = std::chrono::duration_cast<std::chrono::seconds>(time).count();
+                if (second != second_)
+                {
+                    std::time_t t = second;
+                    std::tm tm;
+                    localtime_r(&t, &tm);
+                    second_size_ = std::strftime(second_str_, sizeof(second_str_), "%F %T.", &tm);
+                    second_ = second;
+                }
+
+                char buf[16];
+                auto end = fmt::format_to(buf, "{:09} ", (time - std::chrono::seconds(second)).count());
+                this->append(second_str_, second_size_);
+                this->append(buf, end - buf);
+            }
+
+            void rotate()
+            {
+                this->flush();
+                ::close(fd_);
+
+                std::time_t t = std::time(nullptr);
+                std::tm tm;
+                localtime_r(&t, &tm);
+                char time[32];
+                std::strftime(time, sizeof(time), "%Y%m%d-%H%M%S", &tm);
+
+                auto path = fmt::format("{}.{}.{}", path_, time, ++sequence_);
+                if (std::rename(path_.c_str(), path.c_str()) != 0)
+                    throw std::system_error(errno, std::generic_category(), "can not rotate " + path_);
+
+                this->open();
+                if (compressor_)
+                    compressor_->push(std::move(path));
+            }
+
+        public:
+            /**
+             * @brief 构造
+             *
+             * @param path 文件路径 已存在时追加
+             * @param options
+             */
+            file_sink(std::string path, file_options options = {})
+                : path_(std::move(path)), options_(std::move(options))
+            {
+                if (!options_.compress.empty())
+                    compressor_ = std::make_unique<detail::compressor>(options_.compress);
+                this->open();
+            }
+
+            ~file_sink()
+            {
+                this->detach();
+                this->flush();
+                ::close(fd_);
+            }
+
+            /**
+             * @brief 写入一条日志
+             *
+             * @param time 记录时间
+             * @param str 格式化结果
+             */
+            void write(std::chrono::nanoseconds time, std::string_view str)
+            {
+                if (options_.rotate_interval.count())
+                {
+                    if (next_rotate_ == std::chrono::nanoseconds::max())
+                        next_rotate_ = (time / options_.rotate_interval + 1) * options_.rotate_interval;
+                    else if (time >= next_rotate_)
+                    {
+                        this->rotate();
+                        next_rotate_ = (time / options_.rotate_interval + 1) * options_.rotate_interval;
+                    }
+                }
+
+                if (options_.time)
+                    this->append_time(time);
+                this->append(str.data(), str.size());
+
+                if (buffered_ >= options_.buffer_size || iov_.size() == IOV_MAX)
+                    this->flush();
+
+                if (options_.rotate_size && file_size_ + buffered_ >= options_.rotate_size)
+                    this->rotate();
+            }
+
+            /**
+             * @brief 以 writev 写出所有缓冲块
+             *
+             */
+            void flush() override
+            {
+                auto iov = iov_.data();
+                auto count = iov_.size();
+                while (count)
+                {
+                    auto ret = ::writev(fd_, iov, count);
+                    if (ret < 0)
+                    {
+                        if (errno == EINTR)
+                            continue;
+                        throw std::system_error(errno, std::generic_category(), "can not write " + path_);
+                    }
+
+                    file_size_ += ret;
+                    for (; count && static_cast<std::size_t>(ret) >= iov->iov_len; count--, iov++)
+                        ret -= iov->iov_len;
+
+                    if (count)
+                    {
+                        iov->iov_base = static_cast<char *>(iov->iov_base) + ret;
+                        iov->iov_len -= ret;
+                    }
+                }
+
+                iov_.clear();
+                buffered_ = 0;
+            }
+
+            const std::string &path() const
+            {
+                return path_;
+            }
+        };
+    } // namespace logging
+} // namespace mio
@@ -11,11 +11,17 @@
 #pragma once
 
 #include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include <boost/algorithm/string.hpp>
 
 #include <json/json.h>
 
+#include <mio/serialization/csv.hpp>
+#include <mio/serialization/json.hpp>
+
 namespace mio
 {
     /// @brief 序列化
@@ -34,7 +40,7 @@ namespace mio
 
         /**
          * @brief json 反序列化
-         *
+         * @details 由 jsoncpp 建立完整的 DOM. 解码到结构体或只访问部分路径时 使用不建立 DOM 的 json_parse 与 json_value
          * @tparam Stream
          * @param stream
          * @return Json::Value
@@ -51,51 +57,93 @@ namespace mio
             return value;
         }
 
+        namespace detail
+        {
+            //csv_writer 写出到 std::string
+            struct csv_string_output
+            {
+                std::string &str;
+
+                void write(const char *data, std::size_t size)
+                {
+                    str.append(data, size);
+                }
+            };
+
+            inline void csv_json_field(csv_writer &writer, const Json::Value &value)
+            {
+                if (value.isNull())
+                    writer.field(std::string_view());
+                else if (value.isBool())
+                    writer.field(value.asBool());
+                else if (value.isInt64())
+                    writer.field(value.asInt64());
+                else if (value.isUInt64())
+                    writer.field(value.asUInt64());
+                else if (value.isDouble())
+                    writer.field(value.asDouble());
+                else
+                    writer.field(value.asString());
+            }
+        } // namespace detail
+
         /**
-         * @brief csv 序列化
-         *
-         * @param value 数据
+         * @brief csv 序列化 写出到 csv_writer
+         * @details 数字以 to_chars 直接写入缓冲区, 含分隔符或引号的字符串加引号
+         * @param writer
+         * @param value 数据 格式value[head][index]
          * @param head csv 表头
-         * @param index
-         * @return std::string
+         * @param index 按 value[*index] 的成员名取行, 为空时按下标
          */
-        std::string csv_dump(const Json::Value &value, const std::vector<std::string> &head, const std::optional<std::string> &index)
+        inline void csv_dump(csv_writer &writer, const Json::Value &value, const std::vector<std::string> &head, const std::optional<std::string> &index)
         {
-            std::string ret;
-            ret += boost::algorithm::join(head, ",") + "\n";
+            writer.header(head);
 
             if (index != std::nullopt)
             {
                 for (auto &i : value[*index].getMemberNames())
                 {
                     for (auto &ii : head)
-                    {
-                        ret += value[ii][i].asString() + ",";
-                    }
-
-                    ret.back() = '\n';
+                        detail::csv_json_field(writer, value[ii][i]);
+                    writer.end_row();
                 }
             }
             else
             {
-                int size = value[head[0]].size();
-                for (int i = 0; i < size; i++)
+                Json::ArrayIndex size = value[head[0]].size();
+                for (Json::ArrayIndex i = 0; i < size; i++)
                 {
                     for (auto &ii : head)
-                    {
-                        ret += value[ii][i].asString() + ",";
-                    }
-
-                    ret.back() = '\n';
+                        detail::csv_json_field(writer, value[ii][i]);
+                    writer.end_row();
                 }
             }
+        }
 
+        /**
+         * @brief csv 序列化
+         *
+         * @param value 数据
+         * @param head csv 表头
+         * @param index
+         * @return std::string
+         */
+        std::string csv_dump(const Json::Value &value, const std::vector<std::string> &head, const std::optional<std::string> &index)
+        {
+            std::string ret;
+            detail::csv_string_output output{ret};
+            {
+                csv_options options;
+                options.buffer_size = 64 << 10;
+                csv_writer writer(output, options);
+                csv_dump(writer, value, head, index);
+            }
             return ret;
         }
 
         /**
          * @brief csv 反序列化
-         *
+         * @details 由 csv_reader 解析, 支持引号包围的字段. 需要类型化的列时 直接使用 csv_read
          * @tparam Stream
          * @param stream
          * @param index
@@ -104,33 +152,104 @@ namespace mio
         template <typename Stream>
         Json::Value csv_load(Stream &&stream, const std::optional<std::string> &index)
         {
-            std::string line;
-            std::getline(stream, line);
-
-            std::vector<std::string> head;
-            boost::split(head, line, boost::is_any_of(","));
+            csv_options options;
+            options.infer = false;
+            auto table = csv_read(stream, options);
 
             Json::Value value;
 
-            size_t ind;
+            const csv_column *ind = nullptr;
             if (index != std::nullopt)
-                ind = std::find(head.begin(), head.end(), *index) - head.begin();
+                ind = &table[*index];
 
-            for (int i = 0; std::getline(stream, line); i++)
+            auto rows = table.rows();
+            for (auto &column : table.columns)
             {
-                std::vector<std::string> ve;
-                boost::split(ve, line, boost::is_any_of(","));
-
-                for (int ii = 0; ii < head.size(); ii++)
+                auto &col = value[column.name];
+                for (std::size_t i = 0; i < rows; i++)
                 {
-                    if (index != std::nullopt)
-                        value[head[ii]][ve[ind]] = ve[ii];
+                    auto str = column.string(i);
+                    if (ind)
+                        col[std::string(ind->string(i))] = Json::Value(str.data(), str.data() + str.size());
                     else
-                        value[head[ii]][i] = ve[ii];
+                        col[static_cast<Json::ArrayIndex>(i)] = Json::Value(str.data(), str.data() + str.size());
                 }
             }
 
             return value;
         }
+
+        /**
+         * @brief 由 Json::Value 赋值 按 MIO_REFLECT 的描述逐字段读取
+         * @details 支持的类型与 json_write 一致, 缺少的字段与 null 保持原值, 类型不符时抛出 Json::LogicError
+         * @tparam T
+         * @param value
+         * @param out
+         */
+        template <typename T>
+        void json_assign(const Json::Value &value, T &out)
+        {
+            if (value.isNull())
+                return;
+
+            if constexpr (std::is_same_v<T, bool>)
+                out = value.asBool();
+            else if constexpr (std::is_enum_v<T>)
+                out = static_cast<T>(value.asInt64());
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+                out = static_cast<T>(value.asInt64());
+            else if constexpr (std::is_integral_v<T>)
+                out = static_cast<T>(value.asUInt64());
+            else if constexpr (std::is_floating_point_v<T>)
+                out = static_cast<T>(value.asDouble());
+            else if constexpr (detail::is_json_duration<T>::value)
+                out = T(static_cast<typename T::rep>(value.asInt64()));
+            else if constexpr (detail::is_json_optional<T>::value)
+                json_assign(value, out.emplace());
+            else if constexpr (std::is_array_v<T> && std::is_same_v<std::remove_extent_t<T>, char>)
+            {
+                auto str = value.asString();
+                std::memset(out, 0, sizeof(out));
+                std::memcpy(out, str.data(), std::min(str.size(), sizeof(out)));
+            }
+            else if constexpr (std::is_same_v<T, std::string>)
+                out = value.asString();
+            else if constexpr (is_reflectable_v<T>)
+            {
+                reflect_for_each(out, [&](std::string_view name, auto &member)
+                                 {
+                    if (auto *field = value.find(name.data(), name.data() + name.size()))
+                        json_assign(*field, member); });
+            }
+            else if constexpr (requires { out.emplace_back(); })
+            {
+                out.clear();
+                for (auto &i : value)
+                    json_assign(i, out.emplace_back());
+            }
+            else if constexpr (std::is_array_v<T>)
+            {
+                for (Json::ArrayIndex i = 0; i < std::extent_v<T> && i < value.size(); i++)
+                    json_assign(value[i], out[i]);
+            }
+            else
+                static_assert(std::is_void_v<T>, "type is not json deserializable");
+        }
+
+        /**
+         * @brief 由 Json::Value 构造可反射类型
+         *
+         * @tparam T 以 MIO_REFLECT 描述的类型
+         * @param value
+         * @return T
+         */
+        template <typename T>
+            requires is_reflectable_v<T>
+        T json_cast(const Json::Value &value)
+        {
+            T ret{};
+            json_assign(value, ret);
+            return ret;
+        }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,966 @@
+/**
+ * @file arrow.hpp
+ * @author 然Y (inie0722@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include <ratio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <mio/serialization/reflect.hpp>
+
+namespace mio
+{
+    /// @brief 序列化
+    namespace serialization
+    {
+        namespace detail
+        {
+            /// arrow 元数据版本 V5
+            inline constexpr std::int16_t arrow_metadata_version = 4;
+
+            /// arrow Type union 中用到的类型编号
+            enum class arrow_type_id : std::uint8_t
+            {
+                integer = 2,
+                floating_point = 3,
+                boolean = 6,
+                timestamp = 10,
+                fixed_size_binary = 15,
+            };
+
+            /// arrow MessageHeader union 编号
+            enum class arrow_message_type : std::uint8_t
+            {
+                schema = 1,
+                dictionary_batch = 2,
+                record_batch = 3,
+            };
+
+            /// 列的 arrow 类型描述
+            struct arrow_type
+            {
+                arrow_type_id id;
+                std::int32_t bit_width = 0;
+                bool is_signed = false;
+                std::int16_t precision = 0;
+                std::int16_t unit = 0;
+                std::int32_t byte_width = 0;
+
+                bool operator==(const arrow_type &) const = default;
+            };
+
+            /**
+             * @brief flatbuffers 节点
+             * @details 只实现 arrow 元数据需要的子集: table, string, table 向量, struct 向量
+             */
+            struct fb_node
+            {
+                enum class kind
+                {
+                    table,
+                    string,
+                    table_vector,
+                    struct_vector,
+                };
+
+                struct field
+                {
+                    std::uint16_t id;
+                    std::string scalar;
+                    std::size_t align;
+                    std::shared_ptr<fb_node> child;
+                };
+
+                kind type = kind::table;
+                std::vector<field> fields;
+                std::vector<std::shared_ptr<fb_node>> children;
+                std::string bytes;
+                std::size_t count = 0;
+                std::size_t align = 1;
+
+                template <typename V>
+                fb_node &add(std::uint16_t id, V value)
+                {
+                    std::string scalar(sizeof(V), '\0');
+                    std::memcpy(scalar.data(), &value, sizeof(V));
+                    fields.push_back({id, std::move(scalar), sizeof(V), nullptr});
+                    return *this;
+                }
+
+                fb_node &add(std::uint16_t id, std::shared_ptr<fb_node> child)
+                {
+                    fields.push_back({id, std::string(sizeof(std::uint32_t), '\0'), sizeof(std::uint32_t), std::move(child)});
+                    return *this;
+                }
+
+                static std::shared_ptr<fb_node> make_table()
+                {
+                    return std::make_shared<fb_node>();
+                }
+
+                static std::shared_ptr<fb_node> make_string(std::string_view str)
+                {
+                    auto ret = std::make_shared<fb_node>();
+                    ret->type = kind::string;
+                    ret->bytes = str;
+                    return ret;
+                }
+
+                static std::shared_ptr<fb_node> make_vector(std::vector<std::shared_ptr<fb_node>> children)
+                {
+                    auto ret = std::make_shared<fb_node>();
+                    ret->type = kind::table_vector;
+                    ret->children = std::move(children);
+                    return ret;
+                }
+
+                template <typename V>
+                static std::shared_ptr<fb_node> make_vector(const std::vector<V> &values)
+                {
+                    auto ret = std::make_shared<fb_node>();
+                    ret->type = kind::struct_vector;
+                    ret->bytes.assign(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(V));
+                    ret->count = values.size();
+                    ret->align = alignof(V);
+                    return ret;
+                }
+            };
+
+            /**
+             * @brief flatbuffers 编码
+             * @details 自前向后写入, 子对象总是位于引用者之后, vtable 紧挨 table 之前
+             */
+            class fb_writer
+            {
+            private:
+                std::string buf_;
+
+                void pad(std::size_t align, std::size_t offset = 0)
+                {
+                    while ((buf_.size() + offset) % align)
+                        buf_.push_back('\0');
+                }
+
+                template <typename V>
+                void put(std::size_t pos, V value)
+                {
+                    std::memcpy(&buf_[pos], &value, sizeof(V));
+                }
+
+                template <typename V>
+                void append(V value)
+                {
+                    buf_.append(reinterpret_cast<const char *>(&value), sizeof(V));
+                }
+
+                std::size_t write(const fb_node &node)
+                {
+                    switch (node.type)
+                    {
+                    case fb_node::kind::string:
+                    {
+                        pad(sizeof(std::uint32_t));
+                        auto pos = buf_.size();
+                        append(static_cast<std::uint32_t>(node.bytes.size()));
+                        buf_ += node.bytes;
+                        buf_.push_back('\0');
+                        return pos;
+                    }
+                    case fb_node::kind::struct_vector:
+                    {
+                        pad(std::max<std::size_t>(node.align, sizeof(std::uint32_t)), sizeof(std::uint32_t));
+                        auto pos = buf_.size();
+                        append(static_cast<std::uint32_t>(node.count));
+                        buf_ += node.bytes;
+                        return pos;
+                    }
+                    case fb_node::kind::table_vector:
+                    {
+                        pad(sizeof(std::uint32_t));
+                        auto pos = buf_.size();
+                        append(static_cast<std::uint32_t>(node.children.size()));
+                        buf_.append(node.children.size() * sizeof(std::uint32_t), '\0');
+                        for (std::size_t i = 0; i < node.children.size(); i++)
+                        {
+                            auto slot = pos + sizeof(std::uint32_t) * (i + 1);
+                            auto child = write(*node.children[i]);
+                            put(slot, static_cast<std::uint32_t>(child - slot));
+                        }
+                        return pos;
+                    }
+                    default:
+                        break;
+                    }
+
+                    std::uint16_t field_num = 0;
+                    for (auto &field : node.fields)
+                        field_num = std::max<std::uint16_t>(field_num, field.id + 1);
+
+                    //vtable
+                    pad(sizeof(std::uint16_t));
+                    auto vtable = buf_.size();
+                    buf_.append(sizeof(std::uint16_t) * (2 + field_num), '\0');
+
+                    //table 起始按 8 对齐, 保证 64位 字段对齐
+                    pad(8);
+                    auto table = buf_.size();
+                    append(static_cast<std::int32_t>(table - vtable));
+
+                    std::vector<std::size_t> positions;
+                    for (auto &field : node.fields)
+                    {
+                        pad(field.align);
+                        positions.push_back(buf_.size());
+                        put(vtable + sizeof(std::uint16_t) * (2 + field.id), static_cast<std::uint16_t>(buf_.size() - table));
+                        buf_ += field.scalar;
+                    }
+
+                    put(vtable, static_cast<std::uint16_t>(sizeof(std::uint16_t) * (2 + field_num)));
+                    put(vtable + sizeof(std::uint16_t), static_cast<std::uint16_t>(buf_.size() - table));
+
+                    for (std::size_t i = 0; i < node.fields.size(); i++)
+                    {
+                        if (node.fields[i].child)
+                        {
+                            auto child = write(*node.fields[i].child);
+                            put(positions[i], static_cast<std::uint32_t>(child - positions[i]));
+                        }
+                    }
+
+                    return table;
+                }
+
+            public:
+                /**
+                 * @brief 编码 root table
+                 *
+                 * @param root
+                 * @return std::string 长度按 8 对齐
+                 */
+                std::string finish(const fb_node &root)
+                {
+                    buf_.assign(sizeof(std::uint32_t), '\0');
+                    put(0, static_cast<std::uint32_t>(write(root)));
+                    pad(8);
+                    return std::move(buf_);
+                }
+            };
+
+            /**
+             * @brief flatbuffers table 只读视图
+             *
+             */
+            class fb_table
+            {
+            private:
+                std::string_view buf_;
+                std::size_t pos_;
+
+                template <typename V>
+                V read(std::size_t pos) const
+                {
+                    if (pos + sizeof(V) > buf_.size())
+                        throw std::runtime_error("bad flatbuffer");
+
+                    V ret;
+                    std::memcpy(&ret, buf_.data() + pos, sizeof(V));
+                    return ret;
+                }
+
+                std::size_t offset(std::uint16_t id) const
+                {
+                    auto vtable = pos_ - read<std::int32_t>(pos_);
+                    auto size = read<std::uint16_t>(vtable);
+                    auto slot = sizeof(std::uint16_t) * (2 + id);
+                    return slot < size ? read<std::uint16_t>(vtable + slot) : 0;
+                }
+
+                std::size_t deref(std::uint16_t id) const
+                {
+                    auto pos = pos_ + offset(id);
+                    return pos + read<std::uint32_t>(pos);
+                }
+
+            public:
+                fb_table(std::string_view buf, std::size_t pos)
+                    : buf_(buf), pos_(pos)
+                {
+                }
+
+                /// 从 root offset 构造
+                static fb_table root(std::string_view buf)
+                {
+                    fb_table ret(buf, 0);
+                    ret.pos_ = ret.read<std::uint32_t>(0);
+                    return ret;
+                }
+
+                bool has(std::uint16_t id) const
+                {
+                    return offset(id) != 0;
+                }
+
+                template <typename V>
+                V get(std::uint16_t id, V default_value = V()) const
+                {
+                    auto off = offset(id);
+                    return off ? read<V>(pos_ + off) : default_value;
+                }
+
+                fb_table table(std::uint16_t id) const
+                {
+                    if (!has(id))
+                        throw std::runtime_error("bad flatbuffer");
+                    return fb_table(buf_, deref(id));
+                }
+
+                std::string_view string(std::uint16_t id) const
+                {
+                    if (!has(id))
+                        return {};
+
+                    auto pos = deref(id);
+                    auto size = read<std::uint32_t>(pos);
+                    if (pos + sizeof(std::uint32_t) + size > buf_.size())
+                        throw std::runtime_error("bad flatbuffer");
+                    return buf_.substr(pos + sizeof(std::uint32_t), size);
+                }
+
+                std::size_t size(std::uint16_t id) const
+                {
+                    return has(id) ? read<std::uint32_t>(deref(id)) : 0;
+                }
+
+                /// table 向量的第 index 个元素
+                fb_table table(std::uint16_t id, std::size_t index) const
+                {
+                    auto slot = deref(id) + sizeof(std::uint32_t) * (index + 1);
+                    return fb_table(buf_, slot + read<std::uint32_t>(slot));
+                }
+
+                /// struct 向量的第 index 个元素
+                template <typename V>
+                V element(std::uint16_t id, std::size_t index) const
+                {
+                    return read<V>(deref(id) + sizeof(std::uint32_t) + sizeof(V) * index);
+                }
+            };
+
+            /// std::chrono::duration 对应的 arrow TimeUnit, 不支持时为 -1
+            template <typename M>
+            struct arrow_timestamp_unit : std::integral_constant<std::int16_t, -1>
+            {
+            };
+
+            template <typename Rep, typename Period>
+                requires std::is_integral_v<Rep> && (sizeof(Rep) == 8)
+            struct arrow_timestamp_unit<std::chrono::duration<Rep, Period>>
+                : std::integral_constant<std::int16_t, std::is_same_v<Period, std::ratio<1>> ? 0 : std::is_same_v<Period, std::milli> ? 1
+                                                                                           : std::is_same_v<Period, std::micro>   ? 2
+                                                                                           : std::is_same_v<Period, std::nano>    ? 3
+                                                                                                                                  : -1>
+            {
+            };
+
+            /// 推导成员类型对应的 arrow 类型
+            template <typename M>
+            arrow_type make_arrow_type()
+            {
+                if constexpr (std::is_same_v<M, bool>)
+                {
+                    return {arrow_type_id::boolean};
+                }
+                else if constexpr (std::is_integral_v<M>)
+                {
+                    return {arrow_type_id::integer, sizeof(M) * 8, std::is_signed_v<M>};
+                }
+                else if constexpr (std::is_same_v<M, float>)
+                {
+                    return {arrow_type_id::floating_point, 0, false, 1};
+                }
+                else if constexpr (std::is_same_v<M, double>)
+                {
+                    return {arrow_type_id::floating_point, 0, false, 2};
+                }
+                else if constexpr (arrow_timestamp_unit<M>::value >= 0)
+                {
+                    //时间统一视为 自 epoch 起的时间戳
+                    return {arrow_type_id::timestamp, 0, false, 0, arrow_timestamp_unit<M>::value};
+                }
+                else
+                {
+                    static_assert(std::is_trivially_copyable_v<M>, "arrow field must be trivially copyable");
+                    return {arrow_type_id::fixed_size_binary, 0, false, 0, 0, sizeof(M)};
+                }
+            }
+
+            inline std::shared_ptr<fb_node> make_arrow_type_node(const arrow_type &type)
+            {
+                auto ret = fb_node::make_table();
+                switch (type.id)
+                {
+                case arrow_type_id::integer:
+                    ret->add(0, type.bit_width).add(1, type.is_signed);
+                    break;
+                case arrow_type_id::floating_point:
+                    ret->add(0, type.precision);
+                    break;
+                case arrow_type_id::timestamp:
+                    ret->add(0, type.unit);
+                    break;
+                case arrow_type_id::fixed_size_binary:
+                    ret->add(0, type.byte_width);
+                    break;
+                default:
+                    break;
+                }
+                return ret;
+            }
+
+            inline arrow_type read_arrow_type(const fb_table &field)
+            {
+                arrow_type ret{static_cast<arrow_type_id>(field.get<std::uint8_t>(2))};
+                auto type = field.table(3);
+                switch (ret.id)
+                {
+                case arrow_type_id::integer:
+                    ret.bit_width = type.get<std::int32_t>(0);
+                    ret.is_signed = type.get<bool>(1);
+                    break;
+                case arrow_type_id::floating_point:
+                    ret.precision = type.get<std::int16_t>(0);
+                    break;
+                case arrow_type_id::timestamp:
+                    ret.unit = type.get<std::int16_t>(0);
+                    break;
+                case arrow_type_id::fixed_size_binary:
+                    ret.byte_width = type.get<std::int32_t>(0);
+                    break;
+                case arrow_type_id::boolean:
+                    break;
+                default:
+                    throw std::runtime_error("unsupported arrow type");
+                }
+                return ret;
+            }
+
+            /// 每一列在 arrow 中占用的字节数
+            inline std::size_t arrow_width(const arrow_type &type, std::size_t size)
+            {
+                return type.id == arrow_type_id::fixed_size_binary ? type.byte_width : size;
+            }
+
+            struct arrow_block
+            {
+                std::int64_t offset;
+                std::int32_t meta_data_length;
+                std::int32_t padding;
+                std::int64_t body_length;
+            };
+
+            struct arrow_buffer
+            {
+                std::int64_t offset;
+                std::int64_t length;
+            };
+
+            struct arrow_field_node
+            {
+                std::int64_t length;
+                std::int64_t null_count;
+            };
+
+            inline std::size_t arrow_padding(std::size_t size)
+            {
+                return (8 - size % 8) % 8;
+            }
+
+            /// 带计数的输出, 记录写入的偏移
+            template <typename Stream>
+            class arrow_writer
+            {
+            private:
+                Stream &stream_;
+                std::int64_t offset_ = 0;
+
+            public:
+                arrow_writer(Stream &stream)
+                    : stream_(stream)
+                {
+                }
+
+                void write(const void *data, std::size_t size)
+                {
+                    stream_.write(static_cast<const char *>(data), size);
+                    offset_ += size;
+                }
+
+                void pad(std::size_t size)
+                {
+                    static constexpr char zero[8] = {};
+                    write(zero, arrow_padding(size));
+                }
+
+                template <typename V>
+                void write(V value)
+                {
+                    write(&value, sizeof(V));
+                }
+
+                std::int64_t offset() const
+                {
+                    return offset_;
+                }
+
+                /// 写入封装的 message 元数据 返回元数据总长度
+                std::int32_t message(const std::string &flatbuffer)
+                {
+                    write(static_cast<std::uint32_t>(0xFFFFFFFF));
+                    write(static_cast<std::int32_t>(flatbuffer.size()));
+                    write(flatbuffer.data(), flatbuffer.size());
+                    return flatbuffer.size() + sizeof(std::uint32_t) * 2;
+                }
+            };
+
+            template <typename Stream>
+            bool arrow_read(Stream &stream, void *data, std::size_t size, bool allow_eof = false)
+            {
+                stream.read(static_cast<char *>(data), size);
+                auto count = static_cast<std::size_t>(stream.gcount());
+                if (count == 0 && allow_eof)
+                    return false;
+                if (count != size)
+                    throw std::runtime_error("unexpected end of arrow stream");
+                return true;
+            }
+        }
+
+        /**
+         * @brief arrow 列描述
+         * @details 通过成员指针描述 T 的一个字段, 整数/浮点/bool/时间戳(std::chrono::duration) 映射为对应 arrow 类型,
+         * 其余可平凡复制类型映射为 FixedSizeBinary
+         * @tparam T 行存储类型
+         */
+        template <typename T>
+        struct arrow_field
+        {
+            std::string name;
+            std::size_t offset;
+            std::size_t size;
+            detail::arrow_type type;
+
+            /**
+             * @brief 构造列描述
+             *
+             * @tparam M 成员类型
+             * @param field_name 列名
+             * @param member 成员指针
+             */
+            template <typename M>
+            arrow_field(std::string field_name, M T::*member)
+                : name(std::move(field_name)), size(sizeof(M)), type(detail::make_arrow_type<M>())
+            {
+                alignas(T) static const unsigned char storage[sizeof(T)] = {};
+                auto *object = reinterpret_cast<const T *>(storage);
+                offset = reinterpret_cast<const unsigned char *>(&(object->*member)) - storage;
+            }
+        };
+
+        /**
+         * @brief 由 MIO_REFLECT 的描述生成列描述, 列名为字段名
+         *
+         * @tparam T
+         * @return std::vector<arrow_field<T>>
+         */
+        template <typename T>
+            requires is_reflectable_v<T>
+        std::vector<arrow_field<T>> arrow_fields()
+        {
+            std::vector<arrow_field<T>> ret;
+            reflect_for_each<T>([&](const auto &member)
+                                { ret.emplace_back(std::string(member.name), member.pointer); });
+            return ret;
+        }
+
+        namespace detail
+        {
+            inline std::shared_ptr<fb_node> make_arrow_schema(const std::vector<std::pair<std::string, arrow_type>> &fields,
+                                                             const std::vector<std::pair<std::string, std::string>> &metadata)
+            {
+                std::vector<std::shared_ptr<fb_node>> field_nodes;
+                for (auto &[name, type] : fields)
+                {
+                    auto field = fb_node::make_table();
+                    field->add(0, fb_node::make_string(name))
+                        .add(1, false)
+                        .add(2, static_cast<std::uint8_t>(type.id))
+                        .add(3, make_arrow_type_node(type))
+                        .add(5, fb_node::make_vector({}));
+                    field_nodes.push_back(field);
+                }
+
+                std::vector<std::shared_ptr<fb_node>> kv_nodes;
+                for (auto &[key, value] : metadata)
+                {
+                    auto kv = fb_node::make_table();
+                    kv->add(0, fb_node::make_string(key)).add(1, fb_node::make_string(value));
+                    kv_nodes.push_back(kv);
+                }
+
+                auto schema = fb_node::make_table();
+                schema->add(0, std::int16_t(0)).add(1, fb_node::make_vector(std::move(field_nodes)));
+                if (!kv_nodes.empty())
+                    schema->add(2, fb_node::make_vector(std::move(kv_nodes)));
+                return schema;
+            }
+
+            inline std::string make_arrow_message(arrow_message_type type, std::shared_ptr<fb_node> header, std::int64_t body_length)
+            {
+                auto message = fb_node::make_table();
+                message->add(0, arrow_metadata_version)
+                    .add(1, static_cast<std::uint8_t>(type))
+                    .add(2, std::move(header))
+                    .add(3, body_length);
+                return fb_writer().finish(*message);
+            }
+
+            /**
+             * @brief 写出 arrow 文件
+             *
+             * @tparam Stream
+             * @tparam Table
+             * @tparam Body 每个 record batch 的 body 写出函数 void(writer, first, last)
+             */
+            template <typename Stream, typename Table, typename Body>
+            std::size_t arrow_dump(Stream &stream, Table &table, std::size_t first, std::size_t last, std::size_t batch_size,
+                                   const std::vector<std::pair<std::string, arrow_type>> &fields,
+                                   const std::vector<std::pair<std::string, std::string>> &metadata,
+                                   const std::vector<std::size_t> &widths, Body &&body)
+            {
+                arrow_writer writer(stream);
+                writer.write("ARROW1\0\0", 8);
+
+                auto schema = make_arrow_schema(fields, metadata);
+                writer.message(make_arrow_message(arrow_message_type::schema, schema, 0));
+
+                std::vector<arrow_block> blocks;
+                for (auto batch_first = first; batch_first < last; batch_first += batch_size)
+                {
+                    auto batch_last = std::min(last, batch_first + batch_size);
+                    std::int64_t length = batch_last - batch_first;
+
+                    //等待整批数据写入, 同时保证映射覆盖整批
+                    for (auto i = batch_last; i > batch_first; i--)
+                        table[i - 1].wait();
+
+                    std::vector<arrow_field_node> nodes;
+                    std::vector<arrow_buffer> buffers;
+                    std::int64_t body_length = 0;
+                    for (std::size_t i = 0; i < fields.size(); i++)
+                    {
+                        auto size = fields[i].second.id == arrow_type_id::boolean ? (length + 7) / 8 : length * widths[i];
+                        nodes.push_back({length, 0});
+                        buffers.push_back({body_length, 0});
+                        buffers.push_back({body_length, static_cast<std::int64_t>(size)});
+                        body_length += size + arrow_padding(size);
+                    }
+
+                    auto record_batch = fb_node::make_table();
+                    record_batch->add(0, length)
+                        .add(1, fb_node::make_vector(nodes))
+                        .add(2, fb_node::make_vector(buffers));
+
+                    arrow_block block{writer.offset(), 0, 0, body_length};
+                    block.meta_data_length = writer.message(make_arrow_message(arrow_message_type::record_batch, record_batch, body_length));
+                    body(writer, batch_first, batch_last);
+                    blocks.push_back(block);
+                }
+
+                //EOS
+                writer.write(static_cast<std::uint32_t>(0xFFFFFFFF));
+                writer.write(static_cast<std::int32_t>(0));
+
+                auto footer = fb_node::make_table();
+                footer->add(0, arrow_metadata_version)
+                    .add(1, schema)
+                    .add(2, fb_node::make_vector(std::vector<arrow_block>()))
+                    .add(3, fb_node::make_vector(blocks));
+                auto buf = fb_writer().finish(*footer);
+                writer.write(buf.data(), buf.size());
+                writer.write(static_cast<std::int32_t>(buf.size()));
+                writer.write("ARROW1", 6);
+
+                return last > first ? last - first : 0;
+            }
+        }
+
+        /**
+         * @brief 按列导出 table 为 arrow IPC 文件 (feather v2)
+         * @details 每列先收集到缓冲区再写出, 每个 record batch 最多 batch_size 行
+         * @tparam Stream 输出流 需要 write(const char *, size_t)
+         * @tparam Table mio::tsdb::table
+         * @param stream
+         * @param table
+         * @param first 起始行
+         * @param last 结束行(不包含)
+         * @param fields 列描述
+         * @param batch_size
+         * @return std::size_t 导出行数
+         */
+        template <typename Stream, typename Table>
+        std::size_t arrow_dump(Stream &&stream, Table &table, std::size_t first, std::size_t last,
+                               const std::vector<arrow_field<typename Table::value_type>> &fields, std::size_t batch_size = 65536)
+        {
+            std::vector<std::pair<std::string, detail::arrow_type>> schema;
+            std::vector<std::size_t> widths;
+            for (auto &field : fields)
+            {
+                schema.emplace_back(field.name, field.type);
+                widths.push_back(field.size);
+            }
+
+            std::vector<char> buffer;
+            return detail::arrow_dump(stream, table, first, last, batch_size, schema, {}, widths, [&](auto &writer, std::size_t batch_first, std::size_t batch_last)
+                                      {
+                auto length = batch_last - batch_first;
+                auto *rows = &table[batch_first];
+                for (auto &field : fields)
+                {
+                    if (field.type.id == detail::arrow_type_id::boolean)
+                    {
+                        buffer.assign((length + 7) / 8, 0);
+                        for (std::size_t i = 0; i < length; i++)
+                        {
+                            auto *value = reinterpret_cast<const char *>(&*rows[i]) + field.offset;
+                            if (*reinterpret_cast<const bool *>(value))
+                                buffer[i / 8] |= 1 << (i % 8);
+                        }
+                    }
+                    else
+                    {
+                        buffer.resize(length * field.size);
+                        for (std::size_t i = 0; i < length; i++)
+                        {
+                            auto *value = reinterpret_cast<const char *>(&*rows[i]) + field.offset;
+                            std::memcpy(&buffer[i * field.size], value, field.size);
+                        }
+                    }
+                    writer.write(buffer.data(), buffer.size());
+                    writer.pad(buffer.size());
+                } });
+        }
+
+        /**
+         * @brief 原样导出 table 为 arrow IPC 文件 (feather v2)
+         * @details 整行(包括行头)作为一个 FixedSizeBinary 列 "row", 数据直接从映射内存写出, 没有中间拷贝.
+         * schema 的 custom_metadata 中 mio.value_offset 为值在行内的偏移, mio.value_size 为值的大小
+         * @tparam Stream 输出流 需要 write(const char *, size_t)
+         * @tparam Table mio::tsdb::table
+         * @param stream
+         * @param table
+         * @param first 起始行
+         * @param last 结束行(不包含)
+         * @param batch_size
+         * @return std::size_t 导出行数
+         */
+        template <typename Stream, typename Table>
+        std::size_t arrow_dump(Stream &&stream, Table &table, std::size_t first, std::size_t last, std::size_t batch_size = 65536)
+        {
+            using row_type = typename Table::row_type;
+            using value_type = typename Table::value_type;
+
+            std::size_t value_offset = 0;
+            if (last > first)
+                value_offset = reinterpret_cast<const char *>(&*table[first]) - reinterpret_cast<const char *>(&table[first]);
+
+            detail::arrow_type type{detail::arrow_type_id::fixed_size_binary, 0, false, 0, 0, sizeof(row_type)};
+            return detail::arrow_dump(stream, table, first, last, batch_size, {{"row", type}},
+                                      {{"mio.value_offset", std::to_string(value_offset)}, {"mio.value_size", std::to_string(sizeof(value_type))}},
+                                      {sizeof(row_type)}, [&](auto &writer, std::size_t batch_first, std::size_t batch_last)
+                                      {
+                auto size = (batch_last - batch_first) * sizeof(row_type);
+                writer.write(&table[batch_first], size);
+                writer.pad(size); });
+        }
+
+        /**
+         * @brief 导入 arrow IPC 文件或流, 逐行 push 到 table
+         * @details 按列名匹配 fields, 类型必须一致, 文件中多余的列被忽略. fields 为空时导入 arrow_dump 原样导出的文件.
+         * 不支持压缩与字典编码, 空值按原样读取
+         * @tparam Stream 输入流 需要 read(char *, size_t) 与 gcount()
+         * @tparam Table mio::tsdb::table
+         * @param stream
+         * @param table
+         * @param fields 列描述
+         * @return std::size_t 导入行数
+         */
+        template <typename Stream, typename Table>
+        std::size_t arrow_load(Stream &&stream, Table &table, const std::vector<arrow_field<typename Table::value_type>> &fields = {})
+        {
+            using value_type = typename Table::value_type;
+            static_assert(std::is_trivially_copyable_v<value_type>, "value_type must be trivially copyable");
+
+            char magic[8];
+            detail::arrow_read(stream, magic, 4);
+            std::uint32_t prefix;
+            std::memcpy(&prefix, magic, 4);
+            if (std::string_view(magic, 4) == "ARRO")
+            {
+                detail::arrow_read(stream, magic + 4, 4);
+                if (std::string_view(magic, 6) != "ARROW1")
+                    throw std::runtime_error("bad arrow magic");
+                detail::arrow_read(stream, &prefix, 4);
+            }
+
+            //列在 body 中的数据 buffer 下标, 值内偏移与宽度
+            struct column
+            {
+                std::size_t buffer;
+                std::size_t offset;
+                std::size_t size;
+                bool boolean;
+            };
+
+            std::vector<column> columns;
+            std::string meta;
+            std::vector<char> body;
+            std::size_t count = 0;
+            bool has_schema = false;
+
+            while (true)
+            {
+                std::int32_t length = prefix;
+                if (prefix == 0xFFFFFFFF)
+                    detail::arrow_read(stream, &length, 4);
+                if (length == 0)
+                    break;
+
+                meta.resize(length);
+                detail::arrow_read(stream, meta.data(), length);
+
+                auto message = detail::fb_table::root(meta);
+                auto type = static_cast<detail::arrow_message_type>(message.get<std::uint8_t>(1));
+                auto body_length = message.get<std::int64_t>(3);
+                body.resize(body_length);
+                detail::arrow_read(stream, body.data(), body_length);
+
+                if (type == detail::arrow_message_type::schema)
+                {
+                    auto schema = message.table(2);
+                    std::size_t value_offset = 0;
+                    for (std::size_t i = 0; i < schema.size(2); i++)
+                    {
+                        auto kv = schema.table(2, i);
+                        if (kv.string(0) == "mio.value_offset")
+                            value_offset = std::stoull(std::string(kv.string(1)));
+                    }
+
+                    std::vector<std::pair<std::string_view, detail::arrow_type>> file_fields;
+                    for (std::size_t i = 0; i < schema.size(1); i++)
+                    {
+                        auto field = schema.table(1, i);
+                        file_fields.emplace_back(field.string(0), detail::read_arrow_type(field));
+                    }
+
+                    auto find = [&](std::string_view name, const detail::arrow_type &field_type) -> std::size_t
+                    {
+                        for (std::size_t i = 0; i < file_fields.size(); i++)
+                        {
+                            if (file_fields[i].first != name)
+                                continue;
+                            if (!(file_fields[i].second == field_type))
+                                throw std::runtime_error("arrow type mismatch: " + std::string(name));
+                            return i;
+                        }
+                        throw std::runtime_error("arrow column not found: " + std::string(name));
+                    };
+
+                    if (fields.empty())
+                    {
+                        detail::arrow_type row{detail::arrow_type_id::fixed_size_binary, 0, false, 0, 0, sizeof(typename Table::row_type)};
+                        columns.push_back({find("row", row) * 2 + 1, value_offset, sizeof(value_type), false});
+                    }
+                    else
+                    {
+                        for (auto &field : fields)
+                        {
+                            columns.push_back({find(field.name, field.type) * 2 + 1, field.offset, field.size, field.type.id == detail::arrow_type_id::boolean});
+                        }
+                    }
+                    has_schema = true;
+                }
+                else if (type == detail::arrow_message_type::record_batch)
+                {
+                    if (!has_schema)
+                        throw std::runtime_error("arrow record batch before schema");
+
+                    auto record_batch = message.table(2);
+                    if (record_batch.has(3))
+                        throw std::runtime_error("compressed arrow body is unsupported");
+
+                    auto rows = record_batch.get<std::int64_t>(0);
+                    std::vector<const char *> data;
+                    for (auto &col : columns)
+                    {
+                        auto buffer = record_batch.element<detail::arrow_buffer>(2, col.buffer);
+                        auto need = col.boolean ? (rows + 7) / 8 : rows * static_cast<std::int64_t>(fields.empty() ? sizeof(typename Table::row_type) : col.size);
+                        if (buffer.offset < 0 || buffer.length < need || buffer.offset + need > body_length)
+                            throw std::runtime_error("bad arrow buffer");
+                        data.push_back(body.data() + buffer.offset);
+                    }
+
+                    for (std::int64_t i = 0; i < rows; i++)
+                    {
+                        value_type value{};
+                        auto *ptr = reinterpret_cast<char *>(&value);
+                        for (std::size_t c = 0; c < columns.size(); c++)
+                        {
+                            auto &col = columns[c];
+                            if (col.boolean)
+                            {
+                                bool bit = (data[c][i / 8] >> (i % 8)) & 1;
+                                std::memcpy(ptr + col.offset, &bit, sizeof(bool));
+                            }
+                            else if (fields.empty())
+                            {
+                                std::memcpy(ptr, data[c] + i * sizeof(typename Table::row_type) + col.offset, col.size);
+                            }
+                            else
+                            {
+                                std::memcpy(ptr + col.offset, data[c] + i * col.size, col.size);
+                            }
+                        }
+                        table.push(value);
+                    }
+                    count += rows;
+                }
+                else
+                {
+                    throw std::runtime_error("unsupported arrow message");
+                }
+
+                //流格式可以没有 EOS
+                if (!detail::arrow_read(stream, &prefix, 4, true))
+                    break;
+            }
+
+            return count;
+        }
+    } // namespace serialization
+} // namespace mio
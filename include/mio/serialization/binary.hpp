@@ -0,0 +1,678 @@
+/**
+ * @file binary.hpp
+ * @author 然Y (inie0722@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <mio/serialization/reflect.hpp>
+
+/**
+ * 二进制记录格式
+ *
+ * | header 32 字节 | 字段描述 field_count 个 | 填充到 64 字节对齐 | 记录 record_size 字节 x N |
+ *
+ * header: magic "MIOB", format(u16), byte_order(u16 0x0102), version(u32 用户 schema 版本), record_size(u32),
+ *         record_align(u32), field_count(u32), data_offset(u64)
+ * 字段描述: type(u8), 保留(u8), name_size(u16), offset(u32), size(u32), 保留(u32), num(i64), den(i64), 名字 name_size 字节
+ *
+ * 记录为 T 的原样内存, 数据区 64 字节对齐, mmap 后可以直接作为 T 访问. 记录数由数据区长度得出, 可以流式写入
+ */
+
+namespace mio
+{
+    /// @brief 序列化
+    namespace serialization
+    {
+        /// 字段类型
+        enum class binary_type : std::uint8_t
+        {
+            int_,
+            uint_,
+            float_,
+            boolean,
+            /// std::chrono::duration 整数计数 单位为 num/den 秒
+            duration,
+            /// 定长 char 数组 以 0 填充
+            string,
+            /// 其余可平凡复制类型 按字节比较
+            bytes,
+        };
+
+        /// 字段描述
+        struct binary_column
+        {
+            std::string name;
+            binary_type type;
+            std::uint32_t offset;
+            std::uint32_t size;
+            /// duration 的单位
+            std::int64_t num = 1;
+            std::int64_t den = 1;
+
+            bool operator==(const binary_column &) const = default;
+        };
+
+        namespace detail
+        {
+            inline constexpr char binary_magic[4] = {'M', 'I', 'O', 'B'};
+            inline constexpr std::uint16_t binary_format = 1;
+            inline constexpr std::uint16_t binary_byte_order = 0x0102;
+            inline constexpr std::size_t binary_align = 64;
+
+            struct binary_header
+            {
+                char magic[4];
+                std::uint16_t format;
+                std::uint16_t byte_order;
+                std::uint32_t version;
+                std::uint32_t record_size;
+                std::uint32_t record_align;
+                std::uint32_t field_count;
+                std::uint64_t data_offset;
+            };
+            static_assert(sizeof(binary_header) == 32);
+
+            struct binary_field_header
+            {
+                std::uint8_t type;
+                std::uint8_t reserved;
+                std::uint16_t name_size;
+                std::uint32_t offset;
+                std::uint32_t size;
+                std::uint32_t reserved2;
+                std::int64_t num;
+                std::int64_t den;
+            };
+            static_assert(sizeof(binary_field_header) == 32);
+
+            template <typename M>
+            struct is_binary_duration : std::false_type
+            {
+            };
+
+            template <typename Rep, typename Period>
+            struct is_binary_duration<std::chrono::duration<Rep, Period>> : std::true_type
+            {
+            };
+
+            template <typename M>
+            binary_column make_binary_column(std::string_view name, std::size_t offset)
+            {
+                binary_column ret{std::string(name), binary_type::bytes, static_cast<std::uint32_t>(offset), sizeof(M)};
+                if constexpr (std::is_same_v<M, bool>)
+                    ret.type = binary_type::boolean;
+                else if constexpr (std::is_enum_v<M>)
+                    ret.type = std::is_signed_v<std::underlying_type_t<M>> ? binary_type::int_ : binary_type::uint_;
+                else if constexpr (std::is_integral_v<M>)
+                    ret.type = std::is_signed_v<M> ? binary_type::int_ : binary_type::uint_;
+                else if constexpr (std::is_floating_point_v<M>)
+                    ret.type = binary_type::float_;
+                else if constexpr (is_binary_duration<M>::value)
+                {
+                    static_assert(std::is_integral_v<typename M::rep>, "duration rep must be integral");
+                    ret.type = binary_type::duration;
+                    ret.num = M::period::num;
+                    ret.den = M::period::den;
+                }
+                else if constexpr (std::is_array_v<M> && std::is_same_v<std::remove_extent_t<M>, char>)
+                    ret.type = binary_type::string;
+                return ret;
+            }
+
+            inline std::int64_t binary_load_int(const char *data, std::size_t size, bool is_signed)
+            {
+                switch (size)
+                {
+                case 1:
+                    return is_signed ? static_cast<std::int64_t>(*reinterpret_cast<const std::int8_t *>(data)) : static_cast<std::uint8_t>(*data);
+                case 2:
+                {
+                    std::uint16_t value;
+                    std::memcpy(&value, data, 2);
+                    return is_signed ? static_cast<std::int64_t>(static_cast<std::int16_t>(value)) : static_cast<std::int64_t>(value);
+                }
+                case 4:
+                {
+                    std::uint32_t value;
+                    std::memcpy(&value, data, 4);
+                    return is_signed ? static_cast<std::int64_t>(static_cast<std::int32_t>(value)) : static_cast<std::int64_t>(value);
+                }
+                default:
+                {
+                    std::int64_t value;
+                    std::memcpy(&value, data, 8);
+                    return value;
+                }
+                }
+            }
+
+            inline void binary_store_int(char *data, std::size_t size, std::int64_t value)
+            {
+                //小端 取低位
+                std::memcpy(data, &value, size);
+            }
+
+            inline double binary_load_float(const char *data, std::size_t size)
+            {
+                if (size == sizeof(float))
+                {
+                    float value;
+                    std::memcpy(&value, data, sizeof(value));
+                    return value;
+                }
+                double value;
+                std::memcpy(&value, data, sizeof(value));
+                return value;
+            }
+
+            inline void binary_store_float(char *data, std::size_t size, double value)
+            {
+                if (size == sizeof(float))
+                {
+                    float v = static_cast<float>(value);
+                    std::memcpy(data, &v, sizeof(v));
+                }
+                else
+                    std::memcpy(data, &value, sizeof(value));
+            }
+
+            inline bool binary_is_integer(binary_type type)
+            {
+                return type == binary_type::int_ || type == binary_type::uint_;
+            }
+
+            /// 旧字段能否转换为新字段
+            inline bool binary_convertible(const binary_column &from, const binary_column &to)
+            {
+                switch (to.type)
+                {
+                case binary_type::int_:
+                case binary_type::uint_:
+                    return binary_is_integer(from.type) || from.type == binary_type::boolean;
+                case binary_type::float_:
+                    return from.type == binary_type::float_ || binary_is_integer(from.type);
+                case binary_type::boolean:
+                    return from.type == binary_type::boolean;
+                case binary_type::duration:
+                    return from.type == binary_type::duration;
+                case binary_type::string:
+                    return from.type == binary_type::string;
+                default:
+                    return from.type == binary_type::bytes && from.size == to.size;
+                }
+            }
+
+            //按字段描述转换一个字段, 调用前已检查 binary_convertible
+            inline void binary_convert(const binary_column &from, const char *src, const binary_column &to, char *dst)
+            {
+                switch (to.type)
+                {
+                case binary_type::int_:
+                case binary_type::uint_:
+                    binary_store_int(dst, to.size, from.type == binary_type::boolean ? *src != 0 : binary_load_int(src, from.size, from.type == binary_type::int_));
+                    break;
+                case binary_type::float_:
+                    binary_store_float(dst, to.size, from.type == binary_type::float_ ? binary_load_float(src, from.size) : static_cast<double>(binary_load_int(src, from.size, from.type == binary_type::int_)));
+                    break;
+                case binary_type::duration:
+                {
+                    //count * (from.num / from.den) / (to.num / to.den)
+                    auto count = binary_load_int(src, from.size, true);
+                    std::int64_t num = from.num * to.den, den = from.den * to.num;
+                    auto g = std::gcd(num, den);
+                    binary_store_int(dst, to.size, count * (num / g) / (den / g));
+                    break;
+                }
+                case binary_type::string:
+                    std::memset(dst, 0, to.size);
+                    std::memcpy(dst, src, std::min(from.size, to.size));
+                    break;
+                default:
+                    std::memcpy(dst, src, to.size);
+                }
+            }
+        } // namespace detail
+
+        /**
+         * @brief 记录布局
+         * @details 由 MIO_REFLECT 的描述在编译期生成, 或从文件头解码
+         */
+        struct binary_schema
+        {
+            /// 用户 schema 版本
+            std::uint32_t version = 0;
+            std::uint32_t record_size = 0;
+            std::uint32_t record_align = 1;
+            std::vector<binary_column> columns;
+
+            /**
+             * @brief 由 MIO_REFLECT 的描述生成
+             *
+             * @tparam T 可平凡复制的可反射类型
+             * @param version 用户 schema 版本
+             * @return binary_schema
+             */
+            template <typename T>
+                requires is_reflectable_v<T>
+            static binary_schema make(std::uint32_t version = 0)
+            {
+                static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+                static_assert(alignof(T) <= detail::binary_align, "T is over aligned");
+
+                binary_schema ret{version, sizeof(T), alignof(T), {}};
+                reflect_for_each<T>([&](const auto &member)
+                                    {
+                    using M = typename std::decay_t<decltype(member)>::member_type;
+                    ret.columns.push_back(detail::make_binary_column<M>(member.name, member.offset())); });
+                return ret;
+            }
+
+            const binary_column *find(std::string_view name) const
+            {
+                for (auto &i : columns)
+                {
+                    if (i.name == name)
+                        return &i;
+                }
+                return nullptr;
+            }
+
+            /// 编码为文件头 长度为数据区偏移
+            std::string encode() const
+            {
+                std::string ret(sizeof(detail::binary_header), '\0');
+                for (auto &i : columns)
+                {
+                    detail::binary_field_header field{static_cast<std::uint8_t>(i.type), 0, static_cast<std::uint16_t>(i.name.size()),
+                                                      i.offset, i.size, 0, i.num, i.den};
+                    ret.append(reinterpret_cast<const char *>(&field), sizeof(field));
+                    ret.append(i.name);
+                }
+                ret.resize((ret.size() + detail::binary_align - 1) / detail::binary_align * detail::binary_align, '\0');
+
+                detail::binary_header header{{}, detail::binary_format, detail::binary_byte_order, version, record_size, record_align,
+                                             static_cast<std::uint32_t>(columns.size()), ret.size()};
+                std::memcpy(header.magic, detail::binary_magic, sizeof(header.magic));
+                std::memcpy(ret.data(), &header, sizeof(header));
+                return ret;
+            }
+
+            /**
+             * @brief 解码文件头
+             *
+             * @param data
+             * @param size 可用的字节数 不足时返回 std::nullopt
+             * @param data_offset 数据区偏移
+             * @return std::optional<binary_schema>
+             */
+            static std::optional<binary_schema> decode(const char *data, std::size_t size, std::size_t &data_offset)
+            {
+                if (size < sizeof(detail::binary_header))
+                    return std::nullopt;
+
+                detail::binary_header header;
+                std::memcpy(&header, data, sizeof(header));
+                if (std::memcmp(header.magic, detail::binary_magic, sizeof(header.magic)) != 0)
+                    throw std::runtime_error("not a mio binary file");
+                if (header.format != detail::binary_format)
+                    throw std::runtime_error("unsupported binary format " + std::to_string(header.format));
+                if (header.byte_order != detail::binary_byte_order)
+                    throw std::runtime_error("binary byte order mismatch");
+                if (header.record_size == 0 || header.data_offset < sizeof(header) || header.data_offset % detail::binary_align)
+                    throw std::runtime_error("bad binary header");
+
+                data_offset = header.data_offset;
+                if (size < header.data_offset)
+                    return std::nullopt;
+
+                binary_schema ret{header.version, header.record_size, header.record_align, {}};
+                std::size_t pos = sizeof(header);
+                for (std::uint32_t i = 0; i < header.field_count; i++)
+                {
+                    detail::binary_field_header field;
+                    if (pos + sizeof(field) > header.data_offset)
+                        throw std::runtime_error("bad binary header");
+                    std::memcpy(&field, data + pos, sizeof(field));
+                    pos += sizeof(field);
+
+                    if (pos + field.name_size > header.data_offset || field.type > static_cast<std::uint8_t>(binary_type::bytes) ||
+                        field.offset + static_cast<std::uint64_t>(field.size) > header.record_size || field.num <= 0 || field.den <= 0)
+                        throw std::runtime_error("bad binary header");
+
+                    auto type = static_cast<binary_type>(field.type);
+                    bool integer = detail::binary_is_integer(type) || type == binary_type::duration;
+                    if ((integer && field.size != 1 && field.size != 2 && field.size != 4 && field.size != 8) ||
+                        (type == binary_type::float_ && field.size != 4 && field.size != 8) || (type == binary_type::boolean && field.size != 1))
+                        throw std::runtime_error("bad binary field " + std::string(data + pos, field.name_size));
+
+                    ret.columns.push_back({std::string(data + pos, field.name_size), static_cast<binary_type>(field.type), field.offset, field.size, field.num, field.den});
+                    pos += field.name_size;
+                }
+                return ret;
+            }
+        };
+
+        /**
+         * @brief 旧布局到新布局的转换
+         * @details 按字段名匹配: 整数之间, 整数到浮点, 浮点之间, duration 之间(换算单位), 定长字符串之间(截断或补 0)可以转换,
+         * 新布局中缺少的字段为值初始化, 旧布局中多余的字段被忽略. 类型不能转换时抛出 std::runtime_error
+         */
+        class binary_mapping
+        {
+        private:
+            std::vector<std::pair<const binary_column *, const binary_column *>> fields_;
+            binary_schema from_;
+            binary_schema to_;
+            bool identical_ = true;
+
+        public:
+            binary_mapping(binary_schema from, binary_schema to)
+                : from_(std::move(from)), to_(std::move(to))
+            {
+                identical_ = from_.record_size == to_.record_size;
+                for (auto &column : to_.columns)
+                {
+                    auto *src = from_.find(column.name);
+                    if (!src)
+                    {
+                        identical_ = false;
+                        continue;
+                    }
+                    if (!detail::binary_convertible(*src, column))
+                        throw std::runtime_error("incompatible binary field " + column.name);
+
+                    identical_ = identical_ && *src == column;
+                    fields_.emplace_back(src, &column);
+                }
+            }
+
+            binary_mapping(const binary_mapping &) = delete;
+            binary_mapping &operator=(const binary_mapping &) = delete;
+
+            /// 布局一致 记录可以直接使用
+            bool identical() const
+            {
+                return identical_;
+            }
+
+            const binary_schema &from() const
+            {
+                return from_;
+            }
+
+            /**
+             * @brief 转换一条记录
+             *
+             * @param src 旧记录
+             * @param dst 新记录 已值初始化
+             */
+            void convert(const char *src, char *dst) const
+            {
+                if (identical_)
+                {
+                    std::memcpy(dst, src, to_.record_size);
+                    return;
+                }
+
+                for (auto &[from, to] : fields_)
+                    detail::binary_convert(*from, src + from->offset, *to, dst + to->offset);
+            }
+        };
+
+        /**
+         * @brief 写出二进制记录
+         * @details 构造时写出文件头, 之后可以任意次追加记录. 记录原样写出, 没有编码
+         * @tparam T 可平凡复制的可反射类型
+         */
+        template <typename T>
+        class binary_writer
+        {
+        private:
+            std::function<void(const char *, std::size_t)> output_;
+
+        public:
+            /**
+             * @brief 构造
+             *
+             * @tparam Stream 需要 write(const char *, size), 例如 std::ofstream
+             * @param stream
+             * @param version 用户 schema 版本
+             */
+            template <typename Stream>
+            binary_writer(Stream &stream, std::uint32_t version = 0)
+                : output_([&stream](const char *data, std::size_t size)
+                          { stream.write(data, size); })
+            {
+                auto header = binary_schema::make<T>(version).encode();
+                output_(header.data(), header.size());
+            }
+
+            void write(const T &value)
+            {
+                output_(reinterpret_cast<const char *>(&value), sizeof(T));
+            }
+
+            void write(const T *data, std::size_t count)
+            {
+                output_(reinterpret_cast<const char *>(data), count * sizeof(T));
+            }
+        };
+
+        /**
+         * @brief 原地访问二进制记录
+         * @details mmap 文件或使用外部内存(例如共享内存), 不解析记录. 布局与 T 一致时 operator[] 直接返回映射内存中的记录,
+         * 否则按 binary_mapping 的规则以 get 逐条转换
+         * @tparam T 可平凡复制的可反射类型
+         */
+        template <typename T>
+        class binary_view
+        {
+        private:
+            std::unique_ptr<boost::interprocess::mapped_region> region_;
+            const char *data_ = nullptr;
+            std::size_t size_ = 0;
+            std::unique_ptr<binary_mapping> mapping_;
+
+            void open(const char *data, std::size_t size)
+            {
+                std::size_t offset = 0;
+                auto schema = binary_schema::decode(data, size, offset);
+                if (!schema)
+                    throw std::runtime_error("truncated binary header");
+
+                data_ = data + offset;
+                size_ = (size - offset) / schema->record_size;
+                mapping_ = std::make_unique<binary_mapping>(std::move(*schema), binary_schema::make<T>());
+
+                if (mapping_->identical() && reinterpret_cast<std::uintptr_t>(data_) % alignof(T))
+                    throw std::runtime_error("binary records are not aligned");
+            }
+
+        public:
+            /**
+             * @brief mmap 文件
+             *
+             * @param path
+             */
+            binary_view(const std::string &path)
+            {
+                using namespace boost::interprocess;
+                file_mapping file(path.c_str(), read_only);
+                region_ = std::make_unique<mapped_region>(file, read_only);
+                this->open(static_cast<const char *>(region_->get_address()), region_->get_size());
+            }
+
+            /**
+             * @brief 使用外部内存 需要在 view 的生命周期内有效
+             *
+             * @param data 文件头开始的位置 需要 64 字节对齐
+             * @param size
+             */
+            binary_view(const void *data, std::size_t size)
+            {
+                this->open(static_cast<const char *>(data), size);
+            }
+
+            const binary_schema &schema() const
+            {
+                return mapping_->from();
+            }
+
+            /// 布局与 T 一致 可以使用 operator[] begin end
+            bool identical() const
+            {
+                return mapping_->identical();
+            }
+
+            std::size_t size() const
+            {
+                return size_;
+            }
+
+            /// 需要 identical()
+            const T &operator[](std::size_t index) const
+            {
+                return reinterpret_cast<const T *>(data_)[index];
+            }
+
+            /// 需要 identical()
+            const T *begin() const
+            {
+                return reinterpret_cast<const T *>(data_);
+            }
+
+            /// 需要 identical()
+            const T *end() const
+            {
+                return this->begin() + size_;
+            }
+
+            /// 按 binary_mapping 转换后的记录
+            T get(std::size_t index) const
+            {
+                if (index >= size_)
+                    throw std::out_of_range("binary_view index out of range");
+
+                T ret{};
+                mapping_->convert(data_ + index * mapping_->from().record_size, reinterpret_cast<char *>(&ret));
+                return ret;
+            }
+        };
+
+        /**
+         * @brief 写出 tsdb::table 的 [first, last) 行
+         * @details 行头不写出, 值按批拷贝后写出
+         * @tparam Stream 需要 write(const char *, size)
+         * @tparam Table mio::tsdb::table, value_type 为可反射类型
+         * @param stream
+         * @param table
+         * @param first
+         * @param last
+         * @param version 用户 schema 版本
+         * @return std::size_t 行数
+         */
+        template <typename Stream, typename Table>
+        std::size_t binary_dump(Stream &&stream, Table &table, std::size_t first, std::size_t last, std::uint32_t version = 0)
+        {
+            using value_type = typename Table::value_type;
+
+            binary_writer<value_type> writer(stream, version);
+            constexpr std::size_t BATCH = 4096;
+            std::vector<value_type> buffer;
+            buffer.reserve(BATCH);
+            for (std::size_t i = first; i < last; i++)
+            {
+                buffer.push_back(table[i].value());
+                if (buffer.size() == BATCH || i + 1 == last)
+                {
+                    writer.write(buffer.data(), buffer.size());
+                    buffer.clear();
+                }
+            }
+            return last - first;
+        }
+
+        /**
+         * @brief 从流中读取二进制记录 逐行 push 到 table
+         * @details 布局不一致时按 binary_mapping 转换, 可以读取管道等不能 mmap 的输入
+         * @tparam Stream 需要 read(char *, size_t) 与 gcount()
+         * @tparam Table mio::tsdb::table 或其他有 push(value_type) 的容器, value_type 为可反射类型
+         * @param stream
+         * @param table
+         * @return std::size_t 行数
+         */
+        template <typename Stream, typename Table>
+        std::size_t binary_load(Stream &&stream, Table &table)
+        {
+            using value_type = typename Table::value_type;
+
+            auto read = [&](char *data, std::size_t size)
+            {
+                stream.read(data, size);
+                return static_cast<std::size_t>(stream.gcount());
+            };
+
+            std::string header(sizeof(detail::binary_header), '\0');
+            if (read(header.data(), header.size()) != header.size())
+                throw std::runtime_error("truncated binary header");
+
+            std::size_t offset = 0;
+            auto schema = binary_schema::decode(header.data(), header.size(), offset);
+            if (!schema)
+            {
+                header.resize(offset);
+                if (read(header.data() + sizeof(detail::binary_header), offset - sizeof(detail::binary_header)) != offset - sizeof(detail::binary_header))
+                    throw std::runtime_error("truncated binary header");
+                schema = binary_schema::decode(header.data(), header.size(), offset);
+            }
+
+            binary_mapping mapping(std::move(*schema), binary_schema::make<value_type>());
+            auto record_size = mapping.from().record_size;
+
+            constexpr std::size_t BATCH = 4096;
+            std::vector<char> buffer(BATCH * record_size);
+            std::size_t count = 0;
+            while (1)
+            {
+                auto size = read(buffer.data(), buffer.size());
+                if (size % record_size)
+                    throw std::runtime_error("truncated binary record");
+
+                for (std::size_t i = 0; i < size / record_size; i++)
+                {
+                    value_type value{};
+                    mapping.convert(buffer.data() + i * record_size, reinterpret_cast<char *>(&value));
+                    table.push(value);
+                }
+                count += size / record_size;
+
+                if (size < buffer.size())
+                    return count;
+            }
+        }
+    } // namespace serialization
+} // namespace mio
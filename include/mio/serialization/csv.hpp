@@ -0,0 +1,1452 @@
+/**
+ * @file csv.hpp
+ * @author 然Y (inie0722@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <mio/serialization/reflect.hpp>
+
+namespace mio
+{
+    /// @brief 序列化
+    namespace serialization
+    {
+        /// csv 列类型
+        enum class csv_type : std::uint8_t
+        {
+            int64,
+            float64,
+            /// 纳秒时间戳 存放在 int64 中
+            timestamp,
+            string,
+        };
+
+        /// csv 读取选项
+        struct csv_options
+        {
+            char delimiter = ',';
+            char quote = '"';
+            /// 第一行为表头 否则列名为 "0" "1" ...
+            bool header = true;
+            /// 列类型 为空时按第一行数据推断, 推断的列遇到不符合的值时 int64 -> float64 -> string 逐级放宽
+            std::vector<csv_type> types;
+            /// types 为空时是否推断 否则全部为 string
+            bool infer = true;
+            /// 从流读取时每次读取的大小
+            std::size_t buffer_size = 1 << 22;
+        };
+
+        /**
+         * @brief csv 列
+         * @details int64 与 timestamp 存放在 int64, float64 存放在 float64, string 连续存放在 chars 中, 以 offsets 分隔.
+         * 空值: int64/timestamp 为 0, float64 为 NaN, string 为空串
+         */
+        struct csv_column
+        {
+            std::string name;
+            csv_type type = csv_type::string;
+            std::vector<std::int64_t> int64;
+            std::vector<double> float64;
+            std::string chars;
+            std::vector<std::size_t> offsets = {0};
+
+            std::size_t size() const
+            {
+                switch (type)
+                {
+                case csv_type::int64:
+                case csv_type::timestamp:
+                    return int64.size();
+                case csv_type::float64:
+                    return float64.size();
+                default:
+                    return offsets.size() - 1;
+                }
+            }
+
+            /// string 列的第 i 个值
+            std::string_view string(std::size_t i) const
+            {
+                return std::string_view(chars.data() + offsets[i], offsets[i + 1] - offsets[i]);
+            }
+
+            /// 清空数据 保留列名与类型
+            void clear()
+            {
+                int64.clear();
+                float64.clear();
+                chars.clear();
+                offsets.assign(1, 0);
+            }
+        };
+
+        /// csv 按列解析的结果
+        struct csv_table
+        {
+            std::vector<csv_column> columns;
+
+            std::size_t rows() const
+            {
+                return columns.empty() ? 0 : columns.front().size();
+            }
+
+            csv_column &operator[](std::string_view name)
+            {
+                for (auto &i : columns)
+                {
+                    if (i.name == name)
+                        return i;
+                }
+                throw std::out_of_range("csv column " + std::string(name) + " not found");
+            }
+
+            const csv_column &operator[](std::string_view name) const
+            {
+                return const_cast<csv_table &>(*this)[name];
+            }
+
+            /// 清空数据 保留列
+            void clear()
+            {
+                for (auto &i : columns)
+                    i.clear();
+            }
+        };
+
+        namespace detail
+        {
+            /// [p, end) 中第一个 a 或 b 的位置, 没有时返回 end
+            inline const char *csv_find(const char *p, const char *end, char a, char b)
+            {
+#if defined(__AVX2__)
+                auto va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b);
+                for (; end - p >= 32; p += 32)
+                {
+                    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+                    unsigned mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)));
+                    if (mask)
+                        return p + __builtin_ctz(mask);
+                }
+#endif
+#if defined(__SSE2__)
+                auto sa = _mm_set1_epi8(a), sb = _mm_set1_epi8(b);
+                for (; end - p >= 16; p += 16)
+                {
+                    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                    unsigned mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, sa), _mm_cmpeq_epi8(v, sb)));
+                    if (mask)
+                        return p + __builtin_ctz(mask);
+                }
+#endif
+                for (; p < end; p++)
+                {
+                    if (*p == a || *p == b)
+                        return p;
+                }
+                return end;
+            }
+
+            /// [p, end) 中字符 c 的个数
+            inline std::size_t csv_count(const char *p, const char *end, char c)
+            {
+                std::size_t ret = 0;
+#if defined(__AVX2__)
+                auto vc = _mm256_set1_epi8(c);
+                for (; end - p >= 32; p += 32)
+                {
+                    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+                    ret += __builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, vc))));
+                }
+#endif
+#if defined(__SSE2__)
+                auto sc = _mm_set1_epi8(c);
+                for (; end - p >= 16; p += 16)
+                {
+                    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                    ret += __builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, sc))));
+                }
+#endif
+                for (; p < end; p++)
+                    ret += *p == c;
+                return ret;
+            }
+
+            inline bool csv_parse(std::string_view str, std::int64_t &value)
+            {
+                if (str.empty())
+                {
+                    value = 0;
+                    return true;
+                }
+
+                auto begin = str.data(), end = begin + str.size();
+                if (*begin == '+')
+                    begin++;
+                auto ret = std::from_chars(begin, end, value);
+                return ret.ec == std::errc() && ret.ptr == end;
+            }
+
+            inline bool csv_parse(std::string_view str, double &value)
+            {
+                if (str.empty())
+                {
+                    value = std::numeric_limits<double>::quiet_NaN();
+                    return true;
+                }
+
+                auto begin = str.data(), end = begin + str.size();
+                if (*begin == '+')
+                    begin++;
+                auto ret = std::from_chars(begin, end, value);
+                return ret.ec == std::errc() && ret.ptr == end;
+            }
+
+            //1970-01-01 起的天数
+            inline std::int64_t days_from_civil(std::int64_t y, unsigned m, unsigned d)
+            {
+                y -= m <= 2;
+                std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+                unsigned yoe = static_cast<unsigned>(y - era * 400);
+                unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+                unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+                return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+            }
+
+            inline bool csv_digits(const char *&p, const char *end, std::size_t count, unsigned &value)
+            {
+                value = 0;
+                for (std::size_t i = 0; i < count; i++, p++)
+                {
+                    if (p == end || *p < '0' || *p > '9')
+                        return false;
+                    value = value * 10 + (*p - '0');
+                }
+                return true;
+            }
+
+            /**
+             * @brief 解析时间戳
+             * @details YYYY-MM-DD, YYYY-MM-DD HH:MM:SS[.小数] 或以 T 分隔, 可以 Z 结尾, 按 UTC 换算为纳秒
+             */
+            inline bool csv_parse_timestamp(std::string_view str, std::int64_t &value)
+            {
+                if (str.empty())
+                {
+                    value = 0;
+                    return true;
+                }
+
+                auto p = str.data(), end = p + str.size();
+                unsigned year, month, day, hour = 0, minute = 0, second = 0;
+                if (!csv_digits(p, end, 4, year) || p == end || *p++ != '-' || !csv_digits(p, end, 2, month) ||
+                    p == end || *p++ != '-' || !csv_digits(p, end, 2, day))
+                    return false;
+                if (month < 1 || month > 12 || day < 1 || day > 31)
+                    return false;
+
+                std::int64_t nanosecond = 0;
+                if (p != end && (*p == ' ' || *p == 'T'))
+                {
+                    p++;
+                    if (!csv_digits(p, end, 2, hour) || p == end || *p++ != ':' || !csv_digits(p, end, 2, minute) ||
+                        p == end || *p++ != ':' || !csv_digits(p, end, 2, second))
+                        return false;
+
+                    if (p != end && *p == '.')
+                    {
+                        p++;
+                        std::int64_t scale = 100000000;
+                        auto begin = p;
+                        for (; p != end && *p >= '0' && *p <= '9'; p++, scale /= 10)
+                            nanosecond += (*p - '0') * scale;
+                        if (p == begin)
+                            return false;
+                    }
+                }
+
+                if (p != end && *p == 'Z')
+                    p++;
+                if (p != end)
+                    return false;
+
+                value = ((days_from_civil(year, month, day) * 24 + hour) * 60 + minute) * 60 + second;
+                value = value * 1000000000 + nanosecond;
+                return true;
+            }
+
+            inline csv_type csv_infer(std::string_view str)
+            {
+                std::int64_t i;
+                double d;
+                if (!str.empty() && csv_parse(str, i))
+                    return csv_type::int64;
+                if (!str.empty() && csv_parse(str, d))
+                    return csv_type::float64;
+                if (!str.empty() && csv_parse_timestamp(str, i))
+                    return csv_type::timestamp;
+                return csv_type::string;
+            }
+
+            inline void csv_append_string(csv_column &column, std::string_view str)
+            {
+                column.chars.append(str);
+                column.offsets.push_back(column.chars.size());
+            }
+
+            //推断的列放宽类型 已有的值转换过去
+            inline void csv_widen(csv_column &column, csv_type type)
+            {
+                if (type == csv_type::float64)
+                {
+                    column.float64.assign(column.int64.begin(), column.int64.end());
+                    column.int64.clear();
+                }
+                else
+                {
+                    char buf[64];
+                    auto size = column.size();
+                    for (std::size_t i = 0; i < size; i++)
+                    {
+                        auto ret = column.type == csv_type::float64 ? std::to_chars(buf, buf + sizeof(buf), column.float64[i])
+                                                                    : std::to_chars(buf, buf + sizeof(buf), column.int64[i]);
+                        auto nan = column.type == csv_type::float64 && std::isnan(column.float64[i]);
+                        csv_append_string(column, nan ? std::string_view() : std::string_view(buf, ret.ptr - buf));
+                    }
+                    column.int64.clear();
+                    column.float64.clear();
+                }
+                column.type = type;
+            }
+        } // namespace detail
+
+        /**
+         * @brief 流式 csv 解析
+         * @details 以 SIMD 查找分隔符与换行, 单元格用 from_chars 直接解析到类型化的列, 不为每个单元格分配内存.
+         * 支持引号包围的字段 其中可以有分隔符, 换行与 "" 转义; 行尾的 \r 会被去掉
+         */
+        class csv_reader
+        {
+        private:
+            struct field
+            {
+                const char *data;
+                std::size_t size;
+                /// 有转义时 内容在 unquoted_ 的 offset 处
+                std::size_t offset;
+                bool escaped;
+                bool quoted;
+            };
+
+            csv_options options_;
+            std::vector<std::string> names_;
+            std::vector<bool> inferred_;
+            bool header_done_ = false;
+            std::size_t line_ = 0;
+
+            std::vector<field> fields_;
+            std::vector<std::string_view> row_;
+            std::string unquoted_;
+            std::vector<char> buffer_;
+
+            [[noreturn]] void error(const std::string &what) const
+            {
+                throw std::runtime_error("csv line " + std::to_string(line_) + ": " + what);
+            }
+
+            //切分一行到 fields_, 行不完整时返回 nullptr
+            const char *split(const char *p, const char *end, bool final)
+            {
+                fields_.clear();
+                unquoted_.clear();
+
+                auto delimiter = options_.delimiter, quote = options_.quote;
+                while (1)
+                {
+                    field f{p, 0, 0, false, false};
+                    if (p != end && *p == quote)
+                    {
+                        f.quoted = true;
+                        auto begin = ++p;
+                        while (1)
+                        {
+                            auto q = static_cast<const char *>(std::memchr(p, quote, end - p));
+                            if (!q)
+                            {
+                                if (final)
+                                    this->error("unterminated quote");
+                                return nullptr;
+                            }
+
+                            //末尾的引号 需要看到下一个字符才能确定是否为转义
+                            if (q + 1 == end && !final)
+                                return nullptr;
+
+                            if (q + 1 != end && q[1] == quote)
+                            {
+                                if (!f.escaped)
+                                {
+                                    f.escaped = true;
+                                    f.offset = unquoted_.size();
+                                }
+                                unquoted_.append(p, q + 1);
+                                p = q + 2;
+                                continue;
+                            }
+
+                            if (f.escaped)
+                            {
+                                unquoted_.append(p, q);
+                                f.size = unquoted_.size() - f.offset;
+                            }
+                            else
+                            {
+                                f.data = begin;
+                                f.size = q - begin;
+                            }
+                            p = q + 1;
+                            break;
+                        }
+
+                        if (p != end && *p == '\r')
+                            p++;
+                        if (p != end && *p != delimiter && *p != '\n')
+                            this->error("unexpected character after closing quote");
+                    }
+                    else
+                    {
+                        auto q = detail::csv_find(p, end, delimiter, '\n');
+                        f.data = p;
+                        f.size = q - p;
+                        p = q;
+                    }
+
+                    if (p == end)
+                    {
+                        if (!final)
+                            return nullptr;
+                        fields_.push_back(f);
+                        return end;
+                    }
+
+                    if (*p == delimiter)
+                    {
+                        fields_.push_back(f);
+                        p++;
+                        continue;
+                    }
+
+                    //换行 去掉未加引号字段末尾的 \r
+                    if (!f.quoted && f.size && f.data[f.size - 1] == '\r')
+                        f.size--;
+                    fields_.push_back(f);
+                    return p + 1;
+                }
+            }
+
+            void header(csv_table &table)
+            {
+                if (options_.header && names_.empty())
+                {
+                    for (auto &i : row_)
+                        names_.emplace_back(i);
+                    return;
+                }
+
+                if (names_.empty())
+                {
+                    for (std::size_t i = 0; i < row_.size(); i++)
+                        names_.push_back(std::to_string(i));
+                }
+
+                if (!options_.types.empty() && options_.types.size() != names_.size())
+                    throw std::invalid_argument("csv types do not match columns");
+
+                if (table.columns.empty())
+                {
+                    for (std::size_t i = 0; i < names_.size(); i++)
+                    {
+                        csv_column column;
+                        column.name = names_[i];
+                        if (!options_.types.empty())
+                            column.type = options_.types[i];
+                        else if (options_.infer)
+                            column.type = detail::csv_infer(i < row_.size() ? row_[i] : std::string_view());
+                        table.columns.push_back(std::move(column));
+                    }
+                }
+                else if (table.columns.size() != names_.size())
+                    throw std::invalid_argument("csv table does not match columns");
+
+                inferred_.assign(names_.size(), options_.types.empty());
+                header_done_ = true;
+            }
+
+            void append(csv_column &column, std::string_view str, bool inferred)
+            {
+                switch (column.type)
+                {
+                case csv_type::int64:
+                {
+                    std::int64_t value;
+                    if (detail::csv_parse(str, value))
+                    {
+                        column.int64.push_back(value);
+                        return;
+                    }
+                    break;
+                }
+                case csv_type::float64:
+                {
+                    double value;
+                    if (detail::csv_parse(str, value))
+                    {
+                        column.float64.push_back(value);
+                        return;
+                    }
+                    break;
+                }
+                case csv_type::timestamp:
+                {
+                    std::int64_t value;
+                    if (detail::csv_parse_timestamp(str, value) || detail::csv_parse(str, value))
+                    {
+                        column.int64.push_back(value);
+                        return;
+                    }
+                    break;
+                }
+                default:
+                    detail::csv_append_string(column, str);
+                    return;
+                }
+
+                if (!inferred)
+                    this->error("can not parse \"" + std::string(str) + "\" in column " + column.name);
+
+                double value;
+                detail::csv_widen(column, column.type == csv_type::int64 && detail::csv_parse(str, value) ? csv_type::float64 : csv_type::string);
+                this->append(column, str, inferred);
+            }
+
+        public:
+            csv_reader(csv_options options = {}) : options_(std::move(options)) {}
+
+            /**
+             * @brief 解析 [begin, end) 中的完整行 追加到 table
+             * @details table 为空时按表头与第一行数据建立列
+             * @param begin
+             * @param end
+             * @param table
+             * @param final end 是否为输入结尾, 为 false 时最后不完整的一行留到下一次
+             * @return const char* 处理到的位置
+             */
+            const char *parse(const char *begin, const char *end, csv_table &table, bool final)
+            {
+                auto p = begin;
+                while (p != end)
+                {
+                    auto next = this->split(p, end, final);
+                    if (!next)
+                        break;
+                    p = next;
+                    line_++;
+
+                    //空行
+                    if (fields_.size() == 1 && fields_[0].size == 0 && !fields_[0].quoted)
+                        continue;
+
+                    row_.clear();
+                    for (auto &i : fields_)
+                        row_.emplace_back(i.escaped ? unquoted_.data() + i.offset : i.data, i.size);
+
+                    if (!header_done_)
+                    {
+                        this->header(table);
+                        if (!header_done_)
+                            continue;
+                    }
+
+                    if (row_.size() != table.columns.size())
+                        this->error(std::to_string(row_.size()) + " fields, expected " + std::to_string(table.columns.size()));
+
+                    for (std::size_t i = 0; i < row_.size(); i++)
+                        this->append(table.columns[i], row_[i], inferred_[i]);
+                }
+                return p;
+            }
+
+            /**
+             * @brief 从流中读取 解析的行数达到 batch_rows 时调用 callback
+             * @details 回调后清空 table 的数据, 内存占用与 batch_rows 和 buffer_size 成正比 而不是与文件大小
+             * @tparam Stream 需要 read(char *, size) 与 gcount(), 例如 std::ifstream
+             * @tparam Callback void(csv_table &)
+             * @param stream
+             * @param callback
+             * @param batch_rows
+             * @return std::size_t 总行数
+             */
+            template <typename Stream, typename Callback>
+            std::size_t read(Stream &&stream, Callback &&callback, std::size_t batch_rows = 65536)
+            {
+                csv_table table;
+                return this->read_batches(stream, table, callback, batch_rows);
+            }
+
+            /**
+             * @brief 从流中读取全部内容
+             *
+             * @tparam Stream 需要 read(char *, size) 与 gcount()
+             * @param stream
+             * @return csv_table
+             */
+            template <typename Stream>
+            csv_table read(Stream &&stream)
+            {
+                csv_table ret;
+                auto callback = [](csv_table &) {};
+                this->read_batches(stream, ret, callback, std::numeric_limits<std::size_t>::max());
+                return ret;
+            }
+
+        private:
+            template <typename Stream, typename Callback>
+            std::size_t read_batches(Stream &stream, csv_table &table, Callback &callback, std::size_t batch_rows)
+            {
+                std::size_t count = 0;
+                std::size_t size = 0;
+                buffer_.resize(std::max<std::size_t>(options_.buffer_size, 1));
+
+                while (1)
+                {
+                    //一行比缓冲区还大时 扩大缓冲区
+                    if (size == buffer_.size())
+                        buffer_.resize(buffer_.size() * 2);
+
+                    stream.read(buffer_.data() + size, buffer_.size() - size);
+                    std::size_t n = stream.gcount();
+                    bool final = n == 0;
+                    size += n;
+
+                    auto begin = buffer_.data();
+                    auto p = this->parse(begin, begin + size, table, final);
+                    size = begin + size - p;
+                    std::memmove(begin, p, size);
+
+                    if (table.rows() >= batch_rows || (final && table.rows() && batch_rows != std::numeric_limits<std::size_t>::max()))
+                    {
+                        count += table.rows();
+                        callback(table);
+                        table.clear();
+                    }
+
+                    if (final)
+                        break;
+                }
+
+                return count + table.rows();
+            }
+        };
+
+        /**
+         * @brief 合并 src 到 dst 的末尾
+         * @details 列类型不同时放宽到两者都能表示的类型
+         * @param dst
+         * @param src
+         */
+        inline void csv_concat(csv_table &dst, csv_table &src)
+        {
+            if (dst.columns.size() != src.columns.size())
+                throw std::invalid_argument("csv tables do not match");
+
+            for (std::size_t i = 0; i < dst.columns.size(); i++)
+            {
+                auto &d = dst.columns[i];
+                auto &s = src.columns[i];
+                if (d.type != s.type)
+                {
+                    auto wide = (d.type == csv_type::int64 && s.type == csv_type::float64) || (d.type == csv_type::float64 && s.type == csv_type::int64)
+                                    ? csv_type::float64
+                                    : csv_type::string;
+                    if (d.type != wide)
+                        detail::csv_widen(d, wide);
+                    if (s.type != wide)
+                        detail::csv_widen(s, wide);
+                }
+
+                d.int64.insert(d.int64.end(), s.int64.begin(), s.int64.end());
+                d.float64.insert(d.float64.end(), s.float64.begin(), s.float64.end());
+                auto base = d.chars.size();
+                d.chars += s.chars;
+                for (std::size_t j = 1; j < s.offsets.size(); j++)
+                    d.offsets.push_back(base + s.offsets[j]);
+            }
+        }
+
+        /**
+         * @brief 读取 csv 到类型化的列
+         *
+         * @tparam Stream 需要 read(char *, size) 与 gcount(), 例如 std::ifstream
+         * @param stream
+         * @param options
+         * @return csv_table
+         */
+        template <typename Stream>
+        csv_table csv_read(Stream &&stream, csv_options options = {})
+        {
+            return csv_reader(std::move(options)).read(stream);
+        }
+
+        /**
+         * @brief 解析内存中的 csv
+         *
+         * @param str
+         * @param options
+         * @return csv_table
+         */
+        inline csv_table csv_parse(std::string_view str, csv_options options = {})
+        {
+            csv_table ret;
+            csv_reader(std::move(options)).parse(str.data(), str.data() + str.size(), ret, true);
+            return ret;
+        }
+
+        namespace detail
+        {
+            /**
+             * @brief 按换行把 [begin, end) 切分为最多 count 块
+             * @details 先并行统计每段中引号的个数, 得到每段起点是否在引号内, 再从每段起点找到第一个不在引号内的换行.
+             * "" 转义不改变奇偶, 要求引号只出现在字段首尾
+             * @return std::vector<const char *> count + 1 个切分点
+             */
+            inline std::vector<const char *> csv_split(const char *begin, const char *end, std::size_t count, char quote)
+            {
+                std::size_t size = end - begin;
+                std::vector<std::size_t> quotes(count, 0);
+                std::vector<std::thread> threads;
+                for (std::size_t i = 0; i + 1 < count; i++)
+                {
+                    threads.emplace_back([&, i]()
+                                         { quotes[i] = csv_count(begin + size * i / count, begin + size * (i + 1) / count, quote); });
+                }
+                for (auto &i : threads)
+                    i.join();
+
+                std::vector<const char *> ret = {begin};
+                std::size_t parity = 0;
+                for (std::size_t i = 1; i < count; i++)
+                {
+                    parity += quotes[i - 1];
+
+                    //上一个切分点越过了本段起点时 从切分点开始, 切分点在引号外
+                    auto p = begin + size * i / count;
+                    bool in_quote = parity % 2;
+                    if (ret.back() > p)
+                    {
+                        p = ret.back();
+                        in_quote = false;
+                    }
+
+                    for (; p != end; p++)
+                    {
+                        if (*p == quote)
+                            in_quote = !in_quote;
+                        else if (*p == '\n' && !in_quote)
+                        {
+                            p++;
+                            break;
+                        }
+                    }
+                    ret.push_back(p);
+                }
+                ret.push_back(end);
+                return ret;
+            }
+        } // namespace detail
+
+        /**
+         * @brief 以多个线程读取 csv 文件
+         * @details mmap 文件后 按不在引号内的换行切分为 threads 块并行解析, 结果按顺序合并.
+         * 列名与推断的列类型取自表头与第一行数据, 各块中推断的列按 csv_concat 的规则放宽.
+         * 错误信息中的行号为块内的行号
+         * @param path 文件路径
+         * @param options
+         * @param threads 线程数 文件较小时减少
+         * @return csv_table
+         */
+        inline csv_table csv_read_file(const std::string &path, csv_options options = {}, std::size_t threads = std::thread::hardware_concurrency())
+        {
+            if (std::filesystem::file_size(path) == 0)
+                return {};
+
+            using namespace boost::interprocess;
+            file_mapping file(path.c_str(), read_only);
+            mapped_region region(file, read_only);
+            region.advise(mapped_region::advice_sequential);
+
+            auto begin = static_cast<const char *>(region.get_address());
+            auto end = begin + region.get_size();
+
+            //每块至少 1MB
+            constexpr std::size_t MIN_CHUNK = 1 << 20;
+            threads = std::max<std::size_t>(1, std::min<std::size_t>(threads, region.get_size() / MIN_CHUNK));
+
+            //由表头与第一行数据 确定列
+            csv_table schema;
+            for (std::size_t size = 1 << 16;; size *= 2)
+            {
+                schema = csv_table();
+                auto last = begin + std::min<std::size_t>(size, end - begin);
+                csv_reader(options).parse(begin, last, schema, last == end);
+                if (schema.rows() || last == end)
+                    break;
+            }
+            //没有数据行
+            if (schema.columns.empty())
+                return schema;
+            schema.clear();
+
+            auto bounds = detail::csv_split(begin, end, threads, options.quote);
+
+            std::vector<csv_table> tables(threads, schema);
+            std::vector<std::exception_ptr> errors(threads);
+            std::vector<std::thread> workers;
+            for (std::size_t i = 0; i < threads; i++)
+            {
+                workers.emplace_back([&, i]()
+                                     {
+                    try
+                    {
+                        auto chunk_options = options;
+                        chunk_options.header = options.header && i == 0;
+                        csv_reader(std::move(chunk_options)).parse(bounds[i], bounds[i + 1], tables[i], true);
+                    }
+                    catch (...)
+                    {
+                        errors[i] = std::current_exception();
+                    } });
+            }
+            for (auto &i : workers)
+                i.join();
+
+            for (auto &i : errors)
+            {
+                if (i)
+                    std::rethrow_exception(i);
+            }
+
+            auto ret = std::move(tables[0]);
+            for (std::size_t i = 1; i < threads; i++)
+            {
+                csv_concat(ret, tables[i]);
+                tables[i] = csv_table();
+            }
+            return ret;
+        }
+
+        /**
+         * @brief 流式 csv 写出
+         * @details 数字以 to_chars 格式化到定长缓冲区, 缓冲区满时写出到流或 fd, 内存占用与输出大小无关.
+         * 字符串含分隔符, 引号或换行时加引号; std::chrono::duration 按 epoch 起的 UTC 时间写为 YYYY-MM-DD HH:MM:SS.小数,
+         * 可由 csv_reader 读回为 timestamp
+         */
+        class csv_writer
+        {
+        private:
+            std::function<void(const char *, std::size_t)> output_;
+            csv_options options_;
+            std::unique_ptr<char[]> buffer_;
+            std::size_t size_ = 0;
+            bool first_ = true;
+
+            char *reserve(std::size_t size)
+            {
+                if (size_ + size > options_.buffer_size)
+                    this->flush();
+                if (size > options_.buffer_size)
+                    throw std::length_error("csv field larger than buffer");
+                return buffer_.get() + size_;
+            }
+
+            void separator()
+            {
+                if (!first_)
+                    *this->reserve(1) = options_.delimiter, size_++;
+                first_ = false;
+            }
+
+            void append(const char *data, std::size_t size)
+            {
+                while (size)
+                {
+                    if (size_ == options_.buffer_size)
+                        this->flush();
+                    auto n = std::min(size, options_.buffer_size - size_);
+                    std::memcpy(buffer_.get() + size_, data, n);
+                    size_ += n;
+                    data += n;
+                    size -= n;
+                }
+            }
+
+        public:
+            /**
+             * @brief 写出到流
+             *
+             * @tparam Stream 需要 write(const char *, size), 例如 std::ofstream
+             * @param stream
+             * @param options 使用 delimiter, quote, buffer_size
+             */
+            template <typename Stream>
+            csv_writer(Stream &stream, csv_options options = {})
+                : output_([&stream](const char *data, std::size_t size)
+                          { stream.write(data, size); }),
+                  options_(std::move(options))
+            {
+                options_.buffer_size = std::max<std::size_t>(options_.buffer_size, 64);
+                buffer_.reset(new char[options_.buffer_size]);
+            }
+
+            /**
+             * @brief 写出到文件描述符
+             *
+             * @param fd
+             * @param options 使用 delimiter, quote, buffer_size
+             */
+            csv_writer(int fd, csv_options options = {})
+                : output_([fd](const char *data, std::size_t size)
+                          {
+                              while (size)
+                              {
+                                  auto ret = ::write(fd, data, size);
+                                  if (ret < 0)
+                                  {
+                                      if (errno == EINTR)
+                                          continue;
+                                      throw std::system_error(errno, std::generic_category(), "can not write csv");
+                                  }
+                                  data += ret;
+                                  size -= ret;
+                              } }),
+                  options_(std::move(options))
+            {
+                options_.buffer_size = std::max<std::size_t>(options_.buffer_size, 64);
+                buffer_.reset(new char[options_.buffer_size]);
+            }
+
+            csv_writer(const csv_writer &) = delete;
+            csv_writer &operator=(const csv_writer &) = delete;
+
+            ~csv_writer()
+            {
+                try
+                {
+                    this->flush();
+                }
+                catch (...)
+                {
+                }
+            }
+
+            /// 写出缓冲的内容
+            void flush()
+            {
+                if (size_)
+                    output_(buffer_.get(), size_);
+                size_ = 0;
+            }
+
+            /// 字符串 需要时加引号并转义
+            csv_writer &field(std::string_view str)
+            {
+                this->separator();
+
+                bool quote = false;
+                for (char c : str)
+                {
+                    if (c == options_.delimiter || c == options_.quote || c == '\n' || c == '\r')
+                    {
+                        quote = true;
+                        break;
+                    }
+                }
+
+                if (!quote)
+                {
+                    this->append(str.data(), str.size());
+                    return *this;
+                }
+
+                this->append(&options_.quote, 1);
+                while (!str.empty())
+                {
+                    auto pos = str.find(options_.quote);
+                    auto n = pos == std::string_view::npos ? str.size() : pos + 1;
+                    this->append(str.data(), n);
+                    if (pos != std::string_view::npos)
+                        this->append(&options_.quote, 1);
+                    str.remove_prefix(n);
+                }
+                this->append(&options_.quote, 1);
+                return *this;
+            }
+
+            csv_writer &field(const char *str)
+            {
+                return this->field(std::string_view(str ? str : ""));
+            }
+
+            csv_writer &field(const std::string &str)
+            {
+                return this->field(std::string_view(str));
+            }
+
+            csv_writer &field(char c)
+            {
+                return this->field(std::string_view(&c, 1));
+            }
+
+            csv_writer &field(bool value)
+            {
+                return this->field(std::string_view(value ? "true" : "false"));
+            }
+
+            /// 整数 浮点数 与枚举, NaN 写为空
+            template <typename V>
+                requires(std::is_arithmetic_v<V> || std::is_enum_v<V>)
+            csv_writer &field(V value)
+            {
+                this->separator();
+                if constexpr (std::is_enum_v<V>)
+                    return this->field_number(static_cast<std::underlying_type_t<V>>(value));
+                else
+                    return this->field_number(value);
+            }
+
+            /// epoch 起的时间
+            template <typename Rep, typename Period>
+            csv_writer &field(std::chrono::duration<Rep, Period> value)
+            {
+                this->separator();
+
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(value).count();
+                auto second = ns / 1000000000, frac = ns % 1000000000;
+                if (frac < 0)
+                    second--, frac += 1000000000;
+                auto days = second / 86400, rest = second % 86400;
+                if (rest < 0)
+                    days--, rest += 86400;
+
+                //civil_from_days
+                days += 719468;
+                std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+                unsigned doe = static_cast<unsigned>(days - era * 146097);
+                unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+                std::int64_t year = static_cast<std::int64_t>(yoe) + era * 400;
+                unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+                unsigned mp = (5 * doy + 2) / 153;
+                unsigned day = doy - (153 * mp + 2) / 5 + 1;
+                unsigned month = mp < 10 ? mp + 3 : mp - 9;
+                year += month <= 2;
+
+                auto p = this->reserve(32);
+                auto put = [&](std::int64_t v, int width)
+                {
+                    for (int i = width - 1; i >= 0; i--, v /= 10)
+                        p[i] = '0' + v % 10;
+                    p += width;
+                };
+                put(year, 4), *p++ = '-', put(month, 2), *p++ = '-', put(day, 2), *p++ = ' ';
+                put(rest / 3600, 2), *p++ = ':', put(rest / 60 % 60, 2), *p++ = ':', put(rest % 60, 2);
+                if (frac)
+                    *p++ = '.', put(frac, 9);
+                size_ = p - buffer_.get();
+                return *this;
+            }
+
+            /// 定长字符数组 到第一个 0 为止
+            template <std::size_t Size>
+            csv_writer &field(const char (&str)[Size])
+            {
+                return this->field(std::string_view(str, ::strnlen(str, Size)));
+            }
+
+            /// 结束一行
+            csv_writer &end_row()
+            {
+                *this->reserve(1) = '\n';
+                size_++;
+                first_ = true;
+                return *this;
+            }
+
+            /// 写出一行
+            template <typename... Args>
+            csv_writer &row(const Args &...args)
+            {
+                (this->field(args), ...);
+                return this->end_row();
+            }
+
+            /// 写出表头
+            csv_writer &header(const std::vector<std::string> &names)
+            {
+                for (auto &i : names)
+                    this->field(i);
+                return this->end_row();
+            }
+
+        private:
+            template <typename V>
+            csv_writer &field_number(V value)
+            {
+                if constexpr (std::is_floating_point_v<V>)
+                {
+                    if (std::isnan(value))
+                        return *this;
+                }
+
+                auto p = this->reserve(64);
+                size_ = std::to_chars(p, p + 64, value).ptr - buffer_.get();
+                return *this;
+            }
+        };
+
+        namespace detail
+        {
+            template <typename M>
+            struct is_csv_duration : std::false_type
+            {
+            };
+
+            template <typename Rep, typename Period>
+            struct is_csv_duration<std::chrono::duration<Rep, Period>> : std::true_type
+            {
+            };
+
+            //把列中第 row 个值转换为 M 写入 dst
+            template <typename M>
+            void csv_assign(void *dst, const csv_column &column, std::size_t row)
+            {
+                M value{};
+                if constexpr (std::is_array_v<M> && std::is_same_v<std::remove_extent_t<M>, char>)
+                {
+                    //定长字符数组 超出截断, 不足补 0
+                    char buf[64];
+                    std::string_view str;
+                    if (column.type == csv_type::string)
+                        str = column.string(row);
+                    else if (column.type == csv_type::float64)
+                        str = std::string_view(buf, std::to_chars(buf, buf + sizeof(buf), column.float64[row]).ptr - buf);
+                    else
+                        str = std::string_view(buf, std::to_chars(buf, buf + sizeof(buf), column.int64[row]).ptr - buf);
+                    std::memcpy(value, str.data(), std::min(str.size(), sizeof(M)));
+                }
+                else if constexpr (is_csv_duration<M>::value)
+                {
+                    //timestamp 列为纳秒, int64 列为 M 的计数
+                    if (column.type == csv_type::timestamp)
+                        value = std::chrono::duration_cast<M>(std::chrono::nanoseconds(column.int64[row]));
+                    else if (column.type == csv_type::int64)
+                        value = M(column.int64[row]);
+                    else
+                    {
+                        std::int64_t ns;
+                        if (!csv_parse_timestamp(column.string(row), ns))
+                            throw std::runtime_error("csv column " + column.name + " is not a timestamp");
+                        value = std::chrono::duration_cast<M>(std::chrono::nanoseconds(ns));
+                    }
+                }
+                else if constexpr (std::is_same_v<M, bool>)
+                {
+                    if (column.type == csv_type::string)
+                    {
+                        auto str = column.string(row);
+                        value = str == "1" || str == "true" || str == "True" || str == "TRUE";
+                    }
+                    else if (column.type == csv_type::float64)
+                        value = column.float64[row] != 0;
+                    else
+                        value = column.int64[row] != 0;
+                }
+                else if constexpr (std::is_arithmetic_v<M> || std::is_enum_v<M>)
+                {
+                    using number = std::conditional_t<std::is_enum_v<M>, std::underlying_type<M>, std::common_type<M>>;
+                    if (column.type == csv_type::float64)
+                        value = static_cast<M>(static_cast<typename number::type>(column.float64[row]));
+                    else if (column.type != csv_type::string)
+                        value = static_cast<M>(static_cast<typename number::type>(column.int64[row]));
+                    else
+                    {
+                        double d;
+                        if (!csv_parse(column.string(row), d))
+                            throw std::runtime_error("csv column " + column.name + " is not a number");
+                        value = static_cast<M>(static_cast<typename number::type>(d));
+                    }
+                }
+                else
+                {
+                    static_assert(!sizeof(M), "unsupported csv field type");
+                }
+                std::memcpy(dst, &value, sizeof(M));
+            }
+
+            //写出 src 处的 M
+            template <typename M>
+            void csv_format(csv_writer &writer, const void *src)
+            {
+                if constexpr (std::is_array_v<M>)
+                    writer.field(*static_cast<const M *>(src));
+                else
+                {
+                    M value;
+                    std::memcpy(&value, src, sizeof(M));
+                    writer.field(value);
+                }
+            }
+        } // namespace detail
+
+        /**
+         * @brief csv 列到结构体成员的映射
+         * @details 支持算术类型, 枚举, bool, std::chrono::duration(timestamp 列按 epoch 起的时间) 与定长 char 数组
+         * @tparam T 行存储类型
+         */
+        template <typename T>
+        struct csv_field
+        {
+            std::string name;
+            std::size_t offset;
+            void (*assign)(void *dst, const csv_column &column, std::size_t row);
+            void (*format)(csv_writer &writer, const void *src);
+
+            /**
+             * @brief 构造列映射
+             *
+             * @tparam M 成员类型
+             * @param field_name 列名
+             * @param member 成员指针
+             */
+            template <typename M>
+            csv_field(std::string field_name, M T::*member)
+                : name(std::move(field_name)), assign(&detail::csv_assign<M>), format(&detail::csv_format<M>)
+            {
+                alignas(T) static const unsigned char storage[sizeof(T)] = {};
+                auto *object = reinterpret_cast<const T *>(storage);
+                offset = reinterpret_cast<const unsigned char *>(&(object->*member)) - storage;
+            }
+        };
+
+        /**
+         * @brief 由 MIO_REFLECT 的描述生成列映射, 列名为字段名
+         *
+         * @tparam T
+         * @return std::vector<csv_field<T>>
+         */
+        template <typename T>
+            requires is_reflectable_v<T>
+        std::vector<csv_field<T>> csv_fields()
+        {
+            std::vector<csv_field<T>> ret;
+            reflect_for_each<T>([&](const auto &member)
+                                { ret.emplace_back(std::string(member.name), member.pointer); });
+            return ret;
+        }
+
+        /**
+         * @brief 把解析后的 csv 逐行 push 到 table
+         * @details 按列名匹配 fields, 没有映射的成员为值初始化, csv 中多余的列被忽略
+         * @tparam Table mio::tsdb::table 或其他有 push(value_type) 的容器
+         * @param csv
+         * @param table
+         * @param fields 默认由 MIO_REFLECT 的描述生成
+         * @return std::size_t 行数
+         */
+        template <typename Table>
+        std::size_t csv_append(const csv_table &csv, Table &table,
+                               const std::vector<csv_field<typename Table::value_type>> &fields = csv_fields<typename Table::value_type>())
+        {
+            using value_type = typename Table::value_type;
+            static_assert(std::is_trivially_copyable_v<value_type>, "value_type must be trivially copyable");
+
+            std::vector<const csv_column *> columns;
+            for (auto &field : fields)
+                columns.push_back(&csv[field.name]);
+
+            auto rows = csv.rows();
+            for (std::size_t i = 0; i < rows; i++)
+            {
+                value_type value{};
+                auto *ptr = reinterpret_cast<char *>(&value);
+                for (std::size_t c = 0; c < fields.size(); c++)
+                    fields[c].assign(ptr + fields[c].offset, *columns[c], i);
+                table.push(value);
+            }
+            return rows;
+        }
+
+        /**
+         * @brief 从流中读取 csv 按批 push 到 table
+         * @details 不经过 Json::Value, 每批 batch_rows 行解析为类型化的列后写入 table, 内存占用与批大小成正比
+         * @tparam Stream 需要 read(char *, size) 与 gcount(), 例如 std::ifstream
+         * @tparam Table mio::tsdb::table
+         * @param stream
+         * @param table
+         * @param fields 列映射 默认由 MIO_REFLECT 的描述生成
+         * @param options
+         * @param batch_rows
+         * @return std::size_t 导入行数
+         */
+        template <typename Stream, typename Table>
+        std::size_t csv_import(Stream &&stream, Table &table,
+                               const std::vector<csv_field<typename Table::value_type>> &fields = csv_fields<typename Table::value_type>(),
+                               csv_options options = {}, std::size_t batch_rows = 65536)
+        {
+            return csv_reader(std::move(options)).read(stream, [&](csv_table &csv)
+                                                       { csv_append(csv, table, fields); },
+                                                       batch_rows);
+        }
+
+        /**
+         * @brief 写出 csv_table
+         *
+         * @param writer
+         * @param csv
+         * @param header 是否写出表头
+         * @return std::size_t 行数
+         */
+        inline std::size_t csv_write(csv_writer &writer, const csv_table &csv, bool header = true)
+        {
+            if (header)
+            {
+                for (auto &column : csv.columns)
+                    writer.field(column.name);
+                writer.end_row();
+            }
+
+            auto rows = csv.rows();
+            for (std::size_t i = 0; i < rows; i++)
+            {
+                for (auto &column : csv.columns)
+                {
+                    switch (column.type)
+                    {
+                    case csv_type::int64:
+                        writer.field(column.int64[i]);
+                        break;
+                    case csv_type::timestamp:
+                        writer.field(std::chrono::nanoseconds(column.int64[i]));
+                        break;
+                    case csv_type::float64:
+                        writer.field(column.float64[i]);
+                        break;
+                    default:
+                        writer.field(column.string(i));
+                    }
+                }
+                writer.end_row();
+            }
+            return rows;
+        }
+
+        /**
+         * @brief 按列映射写出结构体的序列
+         *
+         * @tparam Range 元素为 T 的序列, 例如 std::vector<T>
+         * @param writer
+         * @param range
+         * @param fields 默认由 MIO_REFLECT 的描述生成
+         * @param header 是否写出表头
+         * @return std::size_t 行数
+         */
+        template <typename Range, typename T = std::decay_t<decltype(*std::begin(std::declval<const Range &>()))>>
+        std::size_t csv_write(csv_writer &writer, const Range &range, const std::vector<csv_field<T>> &fields = csv_fields<T>(), bool header = true)
+        {
+            if (header)
+            {
+                for (auto &field : fields)
+                    writer.field(field.name);
+                writer.end_row();
+            }
+
+            std::size_t count = 0;
+            for (auto &value : range)
+            {
+                auto *ptr = reinterpret_cast<const char *>(&value);
+                for (auto &field : fields)
+                    field.format(writer, ptr + field.offset);
+                writer.end_row();
+                count++;
+            }
+            return count;
+        }
+
+        /**
+         * @brief 写出 tsdb::table 的 [first, last) 行
+         *
+         * @tparam Table mio::tsdb::table
+         * @param writer
+         * @param table
+         * @param first
+         * @param last
+         * @param fields 默认由 MIO_REFLECT 的描述生成
+         * @param header 是否写出表头
+         * @return std::size_t 行数
+         */
+        template <typename Table>
+        std::size_t csv_write(csv_writer &writer, Table &table, std::size_t first, std::size_t last,
+                              const std::vector<csv_field<typename Table::value_type>> &fields = csv_fields<typename Table::value_type>(),
+                              bool header = true)
+        {
+            if (header)
+            {
+                for (auto &field : fields)
+                    writer.field(field.name);
+                writer.end_row();
+            }
+
+            for (std::size_t i = first; i < last; i++)
+            {
+                auto *ptr = reinterpret_cast<const char *>(&table[i].value());
+                for (auto &field : fields)
+                    field.format(writer, ptr + field.offset);
+                writer.end_row();
+            }
+            return last - first;
+        }
+    } // namespace serialization
+} // namespace mio
@@ -0,0 +1,1000 @@
+/**
+ * @file json.hpp
+ * @author 然Y (inie0722@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <mio/serialization/reflect.hpp>
+
+namespace mio
+{
+    /// @brief 序列化
+    namespace serialization
+    {
+        namespace detail
+        {
+            template <typename T>
+            struct is_json_duration : std::false_type
+            {
+            };
+
+            template <typename Rep, typename Period>
+            struct is_json_duration<std::chrono::duration<Rep, Period>> : std::true_type
+            {
+            };
+
+            template <typename T>
+            struct is_json_optional : std::false_type
+            {
+            };
+
+            template <typename T>
+            struct is_json_optional<std::optional<T>> : std::true_type
+            {
+            };
+
+            template <typename T>
+            inline constexpr bool is_json_string_v = std::is_convertible_v<const T &, std::string_view> ||
+                                                     (std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>);
+
+            template <typename T>
+            inline constexpr bool is_json_array_v = !is_json_string_v<T> && requires(const T &value) {
+                std::begin(value);
+                std::end(value);
+            };
+
+            inline void json_escape(std::string &out, std::string_view str)
+            {
+                static constexpr char hex[] = "0123456789abcdef";
+
+                out.push_back('"');
+                std::size_t begin = 0;
+                for (std::size_t i = 0; i < str.size(); i++)
+                {
+                    auto c = static_cast<unsigned char>(str[i]);
+                    if (c >= 0x20 && c != '"' && c != '\\')
+                        continue;
+
+                    out.append(str.data() + begin, i - begin);
+                    begin = i + 1;
+                    switch (c)
+                    {
+                    case '"':
+                        out.append("\\\"");
+                        break;
+                    case '\\':
+                        out.append("\\\\");
+                        break;
+                    case '\n':
+                        out.append("\\n");
+                        break;
+                    case '\r':
+                        out.append("\\r");
+                        break;
+                    case '\t':
+                        out.append("\\t");
+                        break;
+                    default:
+                        out.append("\\u00");
+                        out.push_back(hex[c >> 4]);
+                        out.push_back(hex[c & 0xf]);
+                    }
+                }
+                out.append(str.data() + begin, str.size() - begin);
+                out.push_back('"');
+            }
+
+            template <typename V>
+            void json_number(std::string &out, V value)
+            {
+                if constexpr (std::is_floating_point_v<V>)
+                {
+                    //json 没有 nan 与 inf
+                    if (!std::isfinite(value))
+                    {
+                        out.append("null");
+                        return;
+                    }
+                }
+
+                char buf[64];
+                out.append(buf, std::to_chars(buf, buf + sizeof(buf), value).ptr - buf);
+            }
+        } // namespace detail
+
+        /**
+         * @brief 追加 value 的 json 文本
+         * @details 由 MIO_REFLECT 的描述在编译期展开为对象, 不经过 Json::Value. 支持算术类型, 枚举(底层整数),
+         * 字符串与定长 char 数组(到第一个 0 为止), std::chrono::duration(count), std::optional(空为 null),
+         * 序列容器(数组) 与嵌套的可反射类型
+         * @tparam T
+         * @param out
+         * @param value
+         */
+        template <typename T>
+        void json_write(std::string &out, const T &value)
+        {
+            if constexpr (std::is_same_v<T, bool>)
+                out.append(value ? "true" : "false");
+            else if constexpr (std::is_enum_v<T>)
+                detail::json_number(out, static_cast<std::underlying_type_t<T>>(value));
+            else if constexpr (std::is_same_v<T, char>)
+                detail::json_escape(out, std::string_view(&value, 1));
+            else if constexpr (std::is_arithmetic_v<T>)
+                detail::json_number(out, value);
+            else if constexpr (detail::is_json_duration<T>::value)
+                detail::json_number(out, value.count());
+            else if constexpr (detail::is_json_optional<T>::value)
+            {
+                if (value)
+                    json_write(out, *value);
+                else
+                    out.append("null");
+            }
+            else if constexpr (std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>)
+                detail::json_escape(out, std::string_view(value, ::strnlen(value, std::extent_v<T>)));
+            else if constexpr (std::is_convertible_v<const T &, std::string_view>)
+                detail::json_escape(out, std::string_view(value));
+            else if constexpr (is_reflectable_v<T>)
+            {
+                out.push_back('{');
+                bool first = true;
+                reflect_for_each(value, [&](std::string_view name, const auto &member)
+                                 {
+                    if (!first)
+                        out.push_back(',');
+                    first = false;
+                    detail::json_escape(out, name);
+                    out.push_back(':');
+                    json_write(out, member); });
+                out.push_back('}');
+            }
+            else if constexpr (detail::is_json_array_v<T>)
+            {
+                out.push_back('[');
+                bool first = true;
+                for (auto &i : value)
+                {
+                    if (!first)
+                        out.push_back(',');
+                    first = false;
+                    json_write(out, i);
+                }
+                out.push_back(']');
+            }
+            else
+                static_assert(std::is_void_v<T>, "type is not json serializable");
+        }
+
+        /**
+         * @brief 可反射类型的 json 序列化
+         *
+         * @tparam T 以 MIO_REFLECT 描述的类型
+         * @param value
+         * @return std::string
+         */
+        template <typename T>
+            requires is_reflectable_v<T>
+        std::string json_dump(const T &value)
+        {
+            std::string ret;
+            json_write(ret, value);
+            return ret;
+        }
+
+        /// json 值的类型
+        enum class json_type : std::uint8_t
+        {
+            null,
+            boolean,
+            number,
+            string,
+            array,
+            object,
+        };
+
+        namespace detail
+        {
+            //解析位置 错误信息中的偏移相对 begin
+            struct json_cursor
+            {
+                const char *begin;
+                const char *p;
+                const char *end;
+
+                [[noreturn]] void error(const char *msg) const
+                {
+                    throw std::runtime_error(std::string("json ") + msg + " at offset " + std::to_string(p - begin));
+                }
+
+                void skip_ws()
+                {
+                    while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+                        p++;
+                }
+
+                char peek()
+                {
+                    this->skip_ws();
+                    if (p == end)
+                        this->error("unexpected end");
+                    return *p;
+                }
+
+                void expect(char c)
+                {
+                    if (this->peek() != c)
+                        this->error("unexpected character");
+                    p++;
+                }
+
+                bool consume(char c)
+                {
+                    if (this->peek() != c)
+                        return false;
+                    p++;
+                    return true;
+                }
+            };
+
+            /// [p, end) 中第一个 '"' 或 '\\'
+            inline const char *json_find_quote(const char *p, const char *end)
+            {
+#if defined(__AVX2__)
+                auto vq = _mm256_set1_epi8('"'), vb = _mm256_set1_epi8('\\');
+                for (; end - p >= 32; p += 32)
+                {
+                    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+                    unsigned mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, vq), _mm256_cmpeq_epi8(v, vb)));
+                    if (mask)
+                        return p + __builtin_ctz(mask);
+                }
+#endif
+#if defined(__SSE2__)
+                auto sq = _mm_set1_epi8('"'), sb = _mm_set1_epi8('\\');
+                for (; end - p >= 16; p += 16)
+                {
+                    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                    unsigned mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, sq), _mm_cmpeq_epi8(v, sb)));
+                    if (mask)
+                        return p + __builtin_ctz(mask);
+                }
+#endif
+                for (; p < end; p++)
+                {
+                    if (*p == '"' || *p == '\\')
+                        return p;
+                }
+                return end;
+            }
+
+            /// [p, end) 中第一个 '"' '[' ']' '{' '}', 方括号 | 0x20 后与花括号相同
+            inline const char *json_find_structural(const char *p, const char *end)
+            {
+#if defined(__AVX2__)
+                auto vq = _mm256_set1_epi8('"'), vo = _mm256_set1_epi8('{'), vc = _mm256_set1_epi8('}'), vl = _mm256_set1_epi8(0x20);
+                for (; end - p >= 32; p += 32)
+                {
+                    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+                    auto lower = _mm256_or_si256(v, vl);
+                    unsigned mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, vq),
+                                                                         _mm256_or_si256(_mm256_cmpeq_epi8(lower, vo), _mm256_cmpeq_epi8(lower, vc))));
+                    if (mask)
+                        return p + __builtin_ctz(mask);
+                }
+#endif
+#if defined(__SSE2__)
+                auto sq = _mm_set1_epi8('"'), so = _mm_set1_epi8('{'), sc = _mm_set1_epi8('}'), sl = _mm_set1_epi8(0x20);
+                for (; end - p >= 16; p += 16)
+                {
+                    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                    auto lower = _mm_or_si128(v, sl);
+                    unsigned mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, sq), _mm_or_si128(_mm_cmpeq_epi8(lower, so), _mm_cmpeq_epi8(lower, sc))));
+                    if (mask)
+                        return p + __builtin_ctz(mask);
+                }
+#endif
+                for (; p < end; p++)
+                {
+                    char c = *p | 0x20;
+                    if (*p == '"' || c == '{' || c == '}')
+                        return p;
+                }
+                return end;
+            }
+
+            //p 在开头的引号上, 返回结尾引号的位置, escaped 为是否含转义
+            inline const char *json_string_end(json_cursor &c, bool &escaped)
+            {
+                escaped = false;
+                auto p = c.p + 1;
+                while (1)
+                {
+                    p = json_find_quote(p, c.end);
+                    if (p == c.end)
+                        c.error("unterminated string");
+                    if (*p == '"')
+                        return p;
+                    escaped = true;
+                    p += 2;
+                }
+            }
+
+            inline void json_append_utf8(std::string &out, std::uint32_t code)
+            {
+                if (code < 0x80)
+                    out.push_back(static_cast<char>(code));
+                else if (code < 0x800)
+                {
+                    out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+                }
+                else if (code < 0x10000)
+                {
+                    out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+                }
+                else
+                {
+                    out.push_back(static_cast<char>(0xf0 | (code >> 18)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+                }
+            }
+
+            inline std::uint32_t json_hex4(json_cursor &c, const char *p)
+            {
+                if (c.end - p < 4)
+                    c.error("bad unicode escape");
+                std::uint32_t ret = 0;
+                for (int i = 0; i < 4; i++)
+                {
+                    char h = p[i];
+                    ret <<= 4;
+                    if (h >= '0' && h <= '9')
+                        ret |= h - '0';
+                    else if ((h | 0x20) >= 'a' && (h | 0x20) <= 'f')
+                        ret |= (h | 0x20) - 'a' + 10;
+                    else
+                        c.error("bad unicode escape");
+                }
+                return ret;
+            }
+
+            /**
+             * @brief 读取字符串 p 移动到结尾引号之后
+             * @details 不含转义时直接返回原文, 否则反转义到 scratch 并返回 scratch
+             */
+            inline std::string_view json_string(json_cursor &c, std::string &scratch)
+            {
+                if (c.peek() != '"')
+                    c.error("expected string");
+
+                bool escaped;
+                auto last = json_string_end(c, escaped);
+                auto first = c.p + 1;
+                c.p = last + 1;
+                if (!escaped)
+                    return std::string_view(first, last - first);
+
+                scratch.clear();
+                for (auto p = first; p < last;)
+                {
+                    auto q = std::find(p, last, '\\');
+                    scratch.append(p, q);
+                    if (q == last)
+                        break;
+
+                    switch (q[1])
+                    {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        scratch.push_back(q[1]);
+                        break;
+                    case 'b':
+                        scratch.push_back('\b');
+                        break;
+                    case 'f':
+                        scratch.push_back('\f');
+                        break;
+                    case 'n':
+                        scratch.push_back('\n');
+                        break;
+                    case 'r':
+                        scratch.push_back('\r');
+                        break;
+                    case 't':
+                        scratch.push_back('\t');
+                        break;
+                    case 'u':
+                    {
+                        auto code = json_hex4(c, q + 2);
+                        //代理对
+                        if (code >= 0xd800 && code < 0xdc00 && last - q >= 12 && q[6] == '\\' && q[7] == 'u')
+                        {
+                            auto low = json_hex4(c, q + 8);
+                            if (low >= 0xdc00 && low < 0xe000)
+                            {
+                                code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                                q += 6;
+                            }
+                        }
+                        json_append_utf8(scratch, code);
+                        q += 4;
+                        break;
+                    }
+                    default:
+                        c.error("bad escape");
+                    }
+                    p = q + 2;
+                }
+                return scratch;
+            }
+
+            //数字 true false null 的原文
+            inline std::string_view json_token(json_cursor &c)
+            {
+                c.skip_ws();
+                auto first = c.p;
+                while (c.p < c.end && *c.p != ',' && *c.p != '}' && *c.p != ']' && *c.p != ' ' && *c.p != '\n' && *c.p != '\r' && *c.p != '\t')
+                    c.p++;
+                if (first == c.p)
+                    c.error("expected value");
+                return std::string_view(first, c.p - first);
+            }
+
+            /// 跳过一个值 容器内按结构字符计数, 不检查括号是否配对
+            inline void json_skip(json_cursor &c)
+            {
+                switch (c.peek())
+                {
+                case '"':
+                {
+                    bool escaped;
+                    c.p = json_string_end(c, escaped) + 1;
+                    return;
+                }
+                case '{':
+                case '[':
+                {
+                    std::size_t depth = 0;
+                    while (1)
+                    {
+                        c.p = json_find_structural(c.p, c.end);
+                        if (c.p == c.end)
+                            c.error("unterminated container");
+                        if (*c.p == '"')
+                        {
+                            bool escaped;
+                            c.p = json_string_end(c, escaped) + 1;
+                        }
+                        else if ((*c.p | 0x20) == '{')
+                            depth++, c.p++;
+                        else if (c.p++, --depth == 0)
+                            return;
+                    }
+                }
+                default:
+                    json_token(c);
+                }
+            }
+
+            inline bool json_null(json_cursor &c)
+            {
+                if (c.peek() != 'n')
+                    return false;
+                if (json_token(c) != "null")
+                    c.error("bad literal");
+                return true;
+            }
+
+            template <typename V>
+            void json_number(json_cursor &c, V &value)
+            {
+                auto token = json_token(c);
+                auto ret = std::from_chars(token.data(), token.data() + token.size(), value);
+                if (ret.ec != std::errc() || ret.ptr != token.data() + token.size())
+                {
+                    c.p = token.data();
+                    c.error("bad number");
+                }
+            }
+
+            template <typename T>
+            inline constexpr bool is_json_map_v = requires(T &value, std::string key) {
+                typename T::mapped_type;
+                value[std::move(key)];
+            };
+
+            template <typename T>
+            void json_decode(json_cursor &c, T &out);
+        } // namespace detail
+
+        /**
+         * @brief 按需访问的 json 值
+         * @details 只保存值在原文中的位置, 不建立 DOM, 不分配内存. 访问成员或下标时从该位置扫描, 跳过的值只按结构字符计数.
+         * 原文需要在 json_value 的生命周期内有效. 不访问的部分不做完整的语法检查
+         */
+        class json_value
+        {
+        private:
+            const char *begin_ = nullptr;
+            const char *data_ = nullptr;
+            const char *end_ = nullptr;
+
+            detail::json_cursor cursor() const
+            {
+                return {begin_, data_, end_};
+            }
+
+            json_value(const char *begin, const char *data, const char *end)
+                : begin_(begin), data_(data), end_(end)
+            {
+            }
+
+            template <typename T>
+            friend void detail::json_decode(detail::json_cursor &c, T &out);
+
+        public:
+            json_value() = default;
+
+            /**
+             * @brief 整个文档
+             *
+             * @param text
+             */
+            explicit json_value(std::string_view text)
+                : begin_(text.data()), data_(text.data()), end_(text.data() + text.size())
+            {
+                auto c = this->cursor();
+                c.peek();
+                data_ = c.p;
+            }
+
+            json_type type() const
+            {
+                auto c = this->cursor();
+                switch (c.peek())
+                {
+                case '{':
+                    return json_type::object;
+                case '[':
+                    return json_type::array;
+                case '"':
+                    return json_type::string;
+                case 't':
+                case 'f':
+                    return json_type::boolean;
+                case 'n':
+                    return json_type::null;
+                default:
+                    return json_type::number;
+                }
+            }
+
+            /// 值的原文
+            std::string_view raw() const
+            {
+                auto c = this->cursor();
+                detail::json_skip(c);
+                return std::string_view(data_, c.p - data_);
+            }
+
+            /**
+             * @brief 查找对象成员
+             *
+             * @param key
+             * @return std::optional<json_value> 不是对象或没有该成员时为空
+             */
+            std::optional<json_value> find(std::string_view key) const
+            {
+                auto c = this->cursor();
+                if (c.peek() != '{')
+                    return std::nullopt;
+                c.p++;
+                if (c.consume('}'))
+                    return std::nullopt;
+
+                std::string scratch;
+                do
+                {
+                    auto name = detail::json_string(c, scratch);
+                    c.expect(':');
+                    if (name == key)
+                        return json_value(begin_, (c.skip_ws(), c.p), end_);
+                    detail::json_skip(c);
+                } while (c.consume(','));
+                c.expect('}');
+                return std::nullopt;
+            }
+
+            /// 对象成员 没有时抛出 std::out_of_range
+            json_value operator[](std::string_view key) const
+            {
+                auto ret = this->find(key);
+                if (!ret)
+                    throw std::out_of_range("json member not found: " + std::string(key));
+                return *ret;
+            }
+
+            /**
+             * @brief 查找数组元素
+             *
+             * @param index
+             * @return std::optional<json_value> 越界时为空
+             */
+            std::optional<json_value> find(std::size_t index) const
+            {
+                std::optional<json_value> ret;
+                std::size_t i = 0;
+                this->for_each([&](json_value value)
+                               {
+                    if (i++ == index)
+                        ret = value;
+                    return !ret; });
+                return ret;
+            }
+
+            /// 数组元素 越界时抛出 std::out_of_range
+            json_value operator[](std::size_t index) const
+            {
+                auto ret = this->find(index);
+                if (!ret)
+                    throw std::out_of_range("json index out of range");
+                return *ret;
+            }
+
+            /**
+             * @brief 按 JSON Pointer(RFC 6901) 访问, 例如 "/data/0/price"
+             *
+             * @param pointer
+             * @return std::optional<json_value> 路径不存在时为空
+             */
+            std::optional<json_value> at_pointer(std::string_view pointer) const
+            {
+                json_value ret = *this;
+                while (!pointer.empty())
+                {
+                    if (pointer[0] != '/')
+                        throw std::invalid_argument("bad json pointer");
+                    pointer.remove_prefix(1);
+                    auto pos = pointer.find('/');
+                    auto token = pointer.substr(0, pos);
+                    pointer = pos == std::string_view::npos ? std::string_view() : pointer.substr(pos);
+
+                    std::string key;
+                    for (std::size_t i = 0; i < token.size(); i++)
+                    {
+                        if (token[i] == '~' && i + 1 < token.size())
+                            key.push_back(token[++i] == '1' ? '/' : '~');
+                        else
+                            key.push_back(token[i]);
+                    }
+
+                    std::optional<json_value> next;
+                    auto type = ret.type();
+                    if (type == json_type::object)
+                        next = ret.find(std::string_view(key));
+                    else if (type == json_type::array)
+                    {
+                        std::size_t index;
+                        auto [ptr, ec] = std::from_chars(key.data(), key.data() + key.size(), index);
+                        if (ec == std::errc() && ptr == key.data() + key.size())
+                            next = ret.find(index);
+                    }
+
+                    if (!next)
+                        return std::nullopt;
+                    ret = *next;
+                }
+                return ret;
+            }
+
+            /**
+             * @brief 依次访问数组元素或对象成员
+             *
+             * @tparam Func 数组为 f(json_value), 对象为 f(std::string_view key, json_value), 返回 false 时停止.
+             * 值的类型与 Func 不符时抛出 std::runtime_error
+             * @param func
+             */
+            template <typename Func>
+            void for_each(Func &&func) const
+            {
+                auto c = this->cursor();
+                auto call = [&](auto &&...args)
+                {
+                    if constexpr (std::is_same_v<decltype(func(args...)), void>)
+                    {
+                        func(args...);
+                        return true;
+                    }
+                    else
+                        return static_cast<bool>(func(args...));
+                };
+
+                constexpr bool is_array = std::is_invocable_v<Func &, json_value>;
+                constexpr char close = is_array ? ']' : '}';
+                if (c.peek() != (is_array ? '[' : '{'))
+                    c.error(is_array ? "expected array" : "expected object");
+                c.p++;
+                if (c.consume(close))
+                    return;
+
+                std::string scratch;
+                do
+                {
+                    bool next;
+                    if constexpr (is_array)
+                        next = call(json_value(begin_, (c.skip_ws(), c.p), end_));
+                    else
+                    {
+                        auto key = detail::json_string(c, scratch);
+                        c.expect(':');
+                        next = call(key, json_value(begin_, (c.skip_ws(), c.p), end_));
+                    }
+                    if (!next)
+                        return;
+                    detail::json_skip(c);
+                } while (c.consume(','));
+                c.expect(close);
+            }
+
+            /// 数组或对象的元素数
+            std::size_t size() const
+            {
+                std::size_t ret = 0;
+                if (this->type() == json_type::array)
+                    this->for_each([&](json_value)
+                                   { ret++; });
+                else
+                    this->for_each([&](std::string_view, json_value)
+                                   { ret++; });
+                return ret;
+            }
+
+            /// 解码到 out, 支持的类型见 json_parse
+            template <typename T>
+            void get(T &out) const
+            {
+                auto c = this->cursor();
+                detail::json_decode(c, out);
+            }
+
+            template <typename T>
+            T get() const
+            {
+                T ret{};
+                this->get(ret);
+                return ret;
+            }
+        };
+
+        namespace detail
+        {
+            template <typename T>
+            void json_decode(json_cursor &c, T &out)
+            {
+                if constexpr (std::is_same_v<T, json_value>)
+                {
+                    c.skip_ws();
+                    out = json_value(c.begin, c.p, c.end);
+                    json_skip(c);
+                }
+                else if constexpr (is_json_optional<T>::value)
+                {
+                    if (json_null(c))
+                        out.reset();
+                    else
+                        json_decode(c, out.emplace());
+                }
+                else if (json_null(c))
+                {
+                    //null 保持原值
+                }
+                else if constexpr (std::is_same_v<T, bool>)
+                {
+                    auto token = json_token(c);
+                    if (token != "true" && token != "false")
+                        c.error("bad literal");
+                    out = token[0] == 't';
+                }
+                else if constexpr (std::is_enum_v<T>)
+                {
+                    std::underlying_type_t<T> value;
+                    json_number(c, value);
+                    out = static_cast<T>(value);
+                }
+                else if constexpr (std::is_arithmetic_v<T>)
+                    json_number(c, out);
+                else if constexpr (is_json_duration<T>::value)
+                {
+                    typename T::rep value;
+                    json_number(c, value);
+                    out = T(value);
+                }
+                else if constexpr (std::is_same_v<T, std::string>)
+                {
+                    std::string scratch;
+                    out = json_string(c, scratch);
+                }
+                else if constexpr (std::is_array_v<T> && std::is_same_v<std::remove_extent_t<T>, char>)
+                {
+                    std::string scratch;
+                    auto str = json_string(c, scratch);
+                    std::memset(out, 0, sizeof(out));
+                    std::memcpy(out, str.data(), std::min(str.size(), sizeof(out)));
+                }
+                else if constexpr (is_reflectable_v<T>)
+                {
+                    c.expect('{');
+                    if (c.consume('}'))
+                        return;
+
+                    std::string scratch;
+                    do
+                    {
+                        auto key = json_string(c, scratch);
+                        c.expect(':');
+
+                        //字段名在编译期展开比较, 未知的成员跳过
+                        bool found = false;
+                        reflect_for_each(out, [&](std::string_view name, auto &member)
+                                         {
+                            if (!found && name == key)
+                            {
+                                found = true;
+                                json_decode(c, member);
+                            } });
+                        if (!found)
+                            json_skip(c);
+                    } while (c.consume(','));
+                    c.expect('}');
+                }
+                else if constexpr (is_json_map_v<T>)
+                {
+                    out.clear();
+                    c.expect('{');
+                    if (c.consume('}'))
+                        return;
+
+                    std::string scratch;
+                    do
+                    {
+                        auto key = json_string(c, scratch);
+                        c.expect(':');
+                        json_decode(c, out[std::string(key)]);
+                    } while (c.consume(','));
+                    c.expect('}');
+                }
+                else if constexpr (requires { out.emplace_back(); })
+                {
+                    out.clear();
+                    c.expect('[');
+                    if (c.consume(']'))
+                        return;
+                    do
+                        json_decode(c, out.emplace_back());
+                    while (c.consume(','));
+                    c.expect(']');
+                }
+                else if constexpr (requires { std::tuple_size<T>::value; out[0]; } || std::is_array_v<T>)
+                {
+                    //定长数组 多余的元素跳过
+                    constexpr std::size_t size = []
+                    {
+                        if constexpr (std::is_array_v<T>)
+                            return std::extent_v<T>;
+                        else
+                            return std::tuple_size<T>::value;
+                    }();
+                    c.expect('[');
+                    if (c.consume(']'))
+                        return;
+                    std::size_t i = 0;
+                    do
+                    {
+                        if (i < size)
+                            json_decode(c, out[i++]);
+                        else
+                            json_skip(c);
+                    } while (c.consume(','));
+                    c.expect(']');
+                }
+                else
+                    static_assert(std::is_void_v<T>, "type is not json deserializable");
+            }
+        } // namespace detail
+
+        /**
+         * @brief 直接解码 json 到 out 不建立 DOM
+         * @details 可反射类型按字段名匹配对象成员, 未知成员跳过, 缺少的成员与 null 保持原值. 还支持算术类型, 枚举,
+         * std::chrono::duration(count), std::string 与定长 char 数组, std::optional, 序列容器, 定长数组,
+         * 以字符串为键的 map, 以及 json_value(保存位置, 之后按需访问). 语法错误时抛出 std::runtime_error
+         * @tparam T
+         * @param text
+         * @param out
+         */
+        template <typename T>
+        void json_parse(std::string_view text, T &out)
+        {
+            detail::json_cursor c{text.data(), text.data(), text.data() + text.size()};
+            detail::json_decode(c, out);
+            c.skip_ws();
+            if (c.p != c.end)
+                c.error("trailing characters");
+        }
+
+        template <typename T>
+        T json_parse(std::string_view text)
+        {
+            T ret{};
+            json_parse(text, ret);
+            return ret;
+        }
+
+        /**
+         * @brief mmap 的 json 文件
+         * @details 用于较大的文件, root() 按需访问, 或以 json_parse(text(), value) 解码
+         */
+        class json_file
+        {
+        private:
+            std::unique_ptr<boost::interprocess::mapped_region> region_;
+            std::string_view text_;
+
+        public:
+            json_file(const std::string &path)
+            {
+                if (std::filesystem::file_size(path) == 0)
+                    return;
+
+                using namespace boost::interprocess;
+                file_mapping file(path.c_str(), read_only);
+                region_ = std::make_unique<mapped_region>(file, read_only);
+                text_ = std::string_view(static_cast<const char *>(region_->get_address()), region_->get_size());
+            }
+
+            std::string_view text() const
+            {
+                return text_;
+            }
+
+            json_value root() const
+            {
+                return json_value(text_);
+            }
+        };
+    } // namespace serialization
+} // namespace mio
@@ -0,0 +1,157 @@
+/**
+ * @file reflect.hpp
+ * @author 然Y (inie0722@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+//展开 256 次, 支持最多 256 个字段
+#define MIO_REFLECT_EXPAND(...) MIO_REFLECT_EXPAND4(MIO_REFLECT_EXPAND4(MIO_REFLECT_EXPAND4(MIO_REFLECT_EXPAND4(__VA_ARGS__))))
+#define MIO_REFLECT_EXPAND4(...) MIO_REFLECT_EXPAND3(MIO_REFLECT_EXPAND3(MIO_REFLECT_EXPAND3(MIO_REFLECT_EXPAND3(__VA_ARGS__))))
+#define MIO_REFLECT_EXPAND3(...) MIO_REFLECT_EXPAND2(MIO_REFLECT_EXPAND2(MIO_REFLECT_EXPAND2(MIO_REFLECT_EXPAND2(__VA_ARGS__))))
+#define MIO_REFLECT_EXPAND2(...) MIO_REFLECT_EXPAND1(MIO_REFLECT_EXPAND1(MIO_REFLECT_EXPAND1(MIO_REFLECT_EXPAND1(__VA_ARGS__))))
+#define MIO_REFLECT_EXPAND1(...) __VA_ARGS__
+
+#define MIO_REFLECT_PARENS ()
+#define MIO_REFLECT_FOR_EACH(type, ...) __VA_OPT__(MIO_REFLECT_EXPAND(MIO_REFLECT_FOR_EACH_HELPER(type, __VA_ARGS__)))
+#define MIO_REFLECT_FOR_EACH_HELPER(type, member, ...) \
+    ::mio::serialization::reflect_member<type, decltype(type::member)>{#member, &type::member} __VA_OPT__(, MIO_REFLECT_FOR_EACH_AGAIN MIO_REFLECT_PARENS(type, __VA_ARGS__))
+#define MIO_REFLECT_FOR_EACH_AGAIN() MIO_REFLECT_FOR_EACH_HELPER
+
+/**
+ * @brief 在类型所在的命名空间中描述字段, 由 ADL 找到
+ * @details MIO_REFLECT(tick, time, price, volume)
+ */
+#define MIO_REFLECT(type, ...)                                         \
+    inline constexpr auto mio_reflect(const type *)                    \
+    {                                                                  \
+        return std::make_tuple(MIO_REFLECT_FOR_EACH(type, __VA_ARGS__)); \
+    }
+
+/**
+ * @brief 在类型定义内描述字段, 可用于局部类型
+ * @details struct tick { ...; MIO_REFLECT_MEMBERS(tick, time, price, volume) };
+ */
+#define MIO_REFLECT_MEMBERS(type, ...)                                 \
+    static constexpr auto mio_reflect()                                \
+    {                                                                  \
+        return std::make_tuple(MIO_REFLECT_FOR_EACH(type, __VA_ARGS__)); \
+    }
+
+namespace mio
+{
+    /// @brief 序列化
+    namespace serialization
+    {
+        /**
+         * @brief 字段描述
+         *
+         * @tparam T 所属类型
+         * @tparam M 成员类型
+         */
+        template <typename T, typename M>
+        struct reflect_member
+        {
+            using class_type = T;
+            using member_type = M;
+
+            std::string_view name;
+            M T::*pointer;
+
+            constexpr M &get(T &object) const
+            {
+                return object.*pointer;
+            }
+
+            constexpr const M &get(const T &object) const
+            {
+                return object.*pointer;
+            }
+
+            /// 在 T 内的字节偏移
+            std::size_t offset() const
+            {
+                alignas(T) static const unsigned char storage[sizeof(T)] = {};
+                auto *object = reinterpret_cast<const T *>(storage);
+                return reinterpret_cast<const unsigned char *>(&(object->*pointer)) - storage;
+            }
+        };
+
+        /// T 是否以 MIO_REFLECT 或 MIO_REFLECT_MEMBERS 描述
+        template <typename T>
+        inline constexpr bool is_reflectable_v = requires { T::mio_reflect(); } || requires { mio_reflect(static_cast<const T *>(nullptr)); };
+
+        /**
+         * @brief T 的字段描述
+         *
+         * @tparam T
+         * @return constexpr auto std::tuple<reflect_member<T, M>...>
+         */
+        template <typename T>
+            requires is_reflectable_v<T>
+        constexpr auto reflect_fields()
+        {
+            if constexpr (requires { T::mio_reflect(); })
+                return T::mio_reflect();
+            else
+                return mio_reflect(static_cast<const T *>(nullptr));
+        }
+
+        /// T 的字段数
+        template <typename T>
+        inline constexpr std::size_t reflect_size_v = std::tuple_size_v<decltype(reflect_fields<T>())>;
+
+        /**
+         * @brief 依次以字段描述调用 func, 展开发生在编译期
+         *
+         * @tparam T
+         * @tparam Func void(const reflect_member<T, M> &)
+         * @param func
+         */
+        template <typename T, typename Func>
+        constexpr void reflect_for_each(Func &&func)
+        {
+            std::apply([&](const auto &...member)
+                       { (func(member), ...); },
+                       reflect_fields<T>());
+        }
+
+        /**
+         * @brief 依次以 (字段名, 成员引用) 调用 func
+         *
+         * @tparam T 可为 const
+         * @tparam Func void(std::string_view, M &)
+         * @param object
+         * @param func
+         */
+        template <typename T, typename Func>
+        constexpr void reflect_for_each(T &object, Func &&func)
+        {
+            reflect_for_each<std::remove_const_t<T>>([&](const auto &member)
+                                                     { func(member.name, member.get(object)); });
+        }
+
+        /// T 的字段名
+        template <typename T>
+        constexpr std::array<std::string_view, reflect_size_v<T>> reflect_names()
+        {
+            std::array<std::string_view, reflect_size_v<T>> ret{};
+            std::size_t index = 0;
+            reflect_for_each<T>([&](const auto &member)
+                                { ret[index++] = member.name; });
+            return ret;
+        }
+    } // namespace serialization
+} // namespace mio
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <fstream>
 #include <memory>
@@ -175,6 +176,64 @@ namespace mio
             }
         };
 
+        /**
+         * @brief 表的运行统计
+         * @details 计数保存在映射文件的表头中, 包含所有打开该表的进程
+         */
+        struct statistics
+        {
+            std::uint64_t size;          ///< 行数 即累计 push 次数
+            std::uint64_t capacity;      ///< 容量
+            std::uint64_t ref_cout;      ///< 打开次数
+            std::uint64_t recapacity;    ///< 扩容次数
+            std::uint64_t remap;         ///< 重新映射次数
+            std::uint64_t capacity_wait; ///< 等待其他访问者扩容的次数
+            std::uint64_t row_wait;      ///< 通过 table::wait 阻塞等待行写入的次数
+            std::uint64_t parked;        ///< 当前阻塞在 table::wait 的读者数
+            std::uint64_t remap_ns;      ///< 扩容, 等待扩容与重新映射耗费的总纳秒数
+        };
+
+        namespace detail
+        {
+            /// 表头 位于映射文件起始处
+            template <template <typename> typename Atomic>
+            struct header
+            {
+                Atomic<std::uint64_t> size;
+                Atomic<std::uint64_t> capacity;
+                Atomic<std::uint64_t> ref_cout;
+                Atomic<bool> lock;
+
+                //统计计数 与 size 分开缓存行, 避免干扰 push. 属于文件格式, 不随编译器变化
+                alignas(64) Atomic<std::uint64_t> recapacity;
+                Atomic<std::uint64_t> remap;
+                Atomic<std::uint64_t> capacity_wait;
+                Atomic<std::uint64_t> row_wait;
+                Atomic<std::uint64_t> parked;
+                Atomic<std::uint64_t> remap_ns;
+
+                statistics stat() const
+                {
+                    return {size, capacity, ref_cout, recapacity, remap, capacity_wait, row_wait, parked, remap_ns};
+                }
+            };
+        }
+
+        /**
+         * @brief 读取表的运行统计
+         * @details 只读映射表头, 不需要知道行类型, 可在其他进程中调用
+         * @param name 文件名
+         * @return statistics
+         */
+        inline statistics stat(const std::string &name)
+        {
+            using namespace boost::interprocess;
+
+            file_mapping file(name.c_str(), read_only);
+            mapped_region region(file, read_only, 0, sizeof(detail::header<std::atomic>));
+            return static_cast<const detail::header<std::atomic> *>(region.get_address())->stat();
+        }
+
         /**
          * @brief 表
          * @details 每个表包括N个行
@@ -189,13 +248,7 @@ namespace mio
             using row_type = row<value_type, Atomic>;
 
         private:
-            struct header
-            {
-                Atomic<std::uint64_t> size;
-                Atomic<std::uint64_t> capacity;
-                Atomic<std::uint64_t> ref_cout;
-                Atomic<bool> lock;
-            };
+            using header = detail::header<Atomic>;
 
             std::string mmap_name_;
             std::unique_ptr<boost::interprocess::file_mapping> file_mapp_;
@@ -220,6 +273,7 @@ namespace mio
             {
                 std::filesystem::resize_file(mmap_name_, sizeof(header) + header_->capacity * 2 * sizeof(row_type));
                 header_->capacity = header_->capacity * 2;
+                header_->recapacity.fetch_add(1);
             }
 
             /// 重新映射
@@ -233,6 +287,7 @@ namespace mio
 
                 row_ = reinterpret_cast<row_type *>(header_ + 1);
                 capacity_ = this->get_region_capacity();
+                header_->remap.fetch_add(1);
             }
 
             /// 获取现在映射的内存的 capacity
@@ -241,10 +296,14 @@ namespace mio
                 return (region_->get_size() - sizeof(header)) / sizeof(row_type);
             }
 
-            /// 推入数据
-            size_t do_push(const value_type &val, size_t index)
+            /// 保证 index 位于映射范围内 必要时扩容并重新映射
+            void reserve(size_t index)
             {
-                if (index >= capacity_)
+                if (index < capacity_)
+                    return;
+
+                auto start = std::chrono::steady_clock::now();
+                while (index >= capacity_)
                 {
                     auto flag = header_->lock.exchange(true);
 
@@ -254,11 +313,21 @@ namespace mio
                         header_->lock = false;
                         header_->capacity.notify_all();
                     }
+                    else
+                    {
+                        header_->capacity_wait.fetch_add(1);
+                    }
 
                     header_->capacity.wait(capacity_);
                     this->remmap();
                 }
+                header_->remap_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            }
 
+            /// 推入数据
+            size_t do_push(const value_type &val, size_t index)
+            {
+                this->reserve(index);
                 row_[index] = val;
 
                 return index;
@@ -267,20 +336,7 @@ namespace mio
             /// 读取数据
             row_type &do_read(size_t index)
             {
-                if (index >= capacity_)
-                {
-                    auto flag = header_->lock.exchange(true);
-                    if (!flag)
-                    {
-                        this->recapacity();
-                        header_->lock = false;
-                        header_->capacity.notify_all();
-                    }
-
-                    header_->capacity.wait(capacity_);
-
-                    this->remmap();
-                }
+                this->reserve(index);
                 return row_[index];
             }
 
@@ -307,6 +363,12 @@ namespace mio
                 header_->capacity = capacity;
                 header_->ref_cout = 1;
                 header_->lock = false;
+                header_->recapacity = 0;
+                header_->remap = 0;
+                header_->capacity_wait = 0;
+                header_->row_wait = 0;
+                header_->parked = 0;
+                header_->remap_ns = 0;
                 capacity_ = this->get_region_capacity();
             }
 
@@ -371,6 +433,25 @@ namespace mio
                 return const_cast<table *>(this)->do_read(index);
             }
 
+            /**
+             * @brief 阻塞等待行写入
+             * @details 与 row::wait 相同, 但会计入 row_wait 与 parked 统计
+             * @param index
+             * @return row_type&
+             */
+            row_type &wait(size_t index)
+            {
+                auto &row = this->do_read(index);
+                if (!row.has_value())
+                {
+                    header_->row_wait.fetch_add(1);
+                    header_->parked.fetch_add(1);
+                    row.wait();
+                    header_->parked.fetch_sub(1);
+                }
+                return row;
+            }
+
             /**
              * @brief 返回行数
              *
@@ -401,6 +482,16 @@ namespace mio
                 return header_->ref_cout;
             }
 
+            /**
+             * @brief 返回运行统计
+             *
+             * @return statistics
+             */
+            statistics stat() const
+            {
+                return header_->stat();
+            }
+
             /**
              * @brief 紧缩table 使capacity等于size
              *
@@ -0,0 +1,47 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include <mio/chrono.hpp>
+#include <mio/logging/binary.hpp>
+
+/**
+ * 将 mio::logging::binary_sink 写出的二进制日志渲染为文本
+ *
+ * 用法: log_decode <file>
+ * 省略 file 时从标准输入读取, 每行以记录时间开头
+ */
+
+int main(int argc, char **argv)
+{
+    mio::logging::binary_decoder decoder;
+    auto print = [](std::chrono::nanoseconds time, std::string_view str)
+    {
+        auto prefix = mio::to_string(time) + " ";
+        std::fwrite(prefix.data(), 1, prefix.size(), stdout);
+        std::fwrite(str.data(), 1, str.size(), stdout);
+    };
+
+    try
+    {
+        if (argc < 2)
+        {
+            decoder.decode(std::cin, print);
+            return 0;
+        }
+
+        std::ifstream file(argv[1], std::ios::binary);
+        if (!file)
+        {
+            fprintf(stderr, "can not open %s\n", argv[1]);
+            return 1;
+        }
+        decoder.decode(file, print);
+    }
+    catch (const std::exception &e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
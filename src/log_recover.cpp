@@ -0,0 +1,44 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <mio/logging/shm.hpp>
+
+/**
+ * 从崩溃进程留下的共享内存中 恢复 mio::log 尚未写出的二进制记录
+ *
+ * 用法: log_recover <name> <file> [--keep]
+ * 恢复的记录按记录时间排序写入 file, 可用 log_decode 渲染. 默认恢复后删除共享内存, --keep 时保留
+ */
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <name> <file> [--keep]\n", argv[0]);
+        return 1;
+    }
+
+    std::ofstream file(argv[2], std::ios::binary);
+    if (!file)
+    {
+        fprintf(stderr, "can not open %s\n", argv[2]);
+        return 1;
+    }
+
+    try
+    {
+        auto count = mio::logging::shm_recover(argv[1], file);
+        printf("recovered %lu records\n", count);
+    }
+    catch (const std::exception &e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    if (!(argc > 3 && std::strcmp(argv[3], "--keep") == 0))
+        boost::interprocess::shared_memory_object::remove(argv[1]);
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+
+#include <mio/tsdb.hpp>
+
+/**
+ * 打印 tsdb 表的运行统计
+ *
+ * 用法: tsdb_stat <file> [interval_ms]
+ * 指定 interval_ms 时每隔 interval_ms 打印一次, 括号内为区间增量
+ */
+
+void print(const mio::tsdb::statistics &stat, const mio::tsdb::statistics &last)
+{
+    printf("size %lu (+%lu)\tcapacity %lu\tref %lu\trecapacity %lu (+%lu)\tremap %lu (+%lu)\tcapacity_wait %lu (+%lu)\trow_wait %lu (+%lu)\tparked %lu\tremap_ns %lu (+%lu)\n",
+           stat.size, stat.size - last.size, stat.capacity, stat.ref_cout,
+           stat.recapacity, stat.recapacity - last.recapacity,
+           stat.remap, stat.remap - last.remap,
+           stat.capacity_wait, stat.capacity_wait - last.capacity_wait,
+           stat.row_wait, stat.row_wait - last.row_wait,
+           stat.parked,
+           stat.remap_ns, stat.remap_ns - last.remap_ns);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <file> [interval_ms]\n", argv[0]);
+        return 1;
+    }
+
+    mio::tsdb::statistics last{};
+    auto stat = mio::tsdb::stat(argv[1]);
+    print(stat, last);
+
+    if (argc < 3)
+        return 0;
+
+    auto interval = std::chrono::milliseconds(std::strtoull(argv[2], nullptr, 10));
+    while (true)
+    {
+        std::this_thread::sleep_for(interval);
+        last = stat;
+        stat = mio::tsdb::stat(argv[1]);
+        print(stat, last);
+    }
+}
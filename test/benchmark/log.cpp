@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <mio/log.hpp>
+
+/**
+ * log 基准测试
+ *
+ * 覆盖 生产者线程数 x 参数类型 x 输出(fast 只计数, slow 每条忙等 --slow-ns) x overflow 策略,
+ * 统计每次调用的延迟分位数, 以及后端吞吐(第一条写入到最后一条被输出). 结果打印到终端, 并以 json 写入 --output 指定的文件
+ *
+ * 用法: log_benchmark [--producers 1,2,4] [--args int,double,string,mixed] [--sinks fast,slow]
+ *                     [--overflow block,drop,grow] [--count 200000] [--slow-ns 1000] [--output log_benchmark.json]
+ */
+
+using clock_type = std::chrono::steady_clock;
+using log_type = mio::log<>;
+
+struct options
+{
+    std::vector<size_t> producers = {1, 2, 4};
+    std::vector<std::string> args = {"int", "double", "string", "mixed"};
+    std::vector<std::string> sinks = {"fast", "slow"};
+    std::vector<std::string> overflow = {"block", "drop", "grow"};
+    size_t count = 200000;
+    uint64_t slow_ns = 1000;
+    std::string output = "log_benchmark.json";
+};
+
+struct summary
+{
+    size_t count = 0;
+    uint64_t mean = 0;
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+
+    static summary make(std::vector<uint64_t> &samples)
+    {
+        summary ret;
+        ret.count = samples.size();
+        if (samples.empty())
+            return ret;
+
+        std::sort(samples.begin(), samples.end());
+        auto at = [&](double q)
+        { return samples[std::min(samples.size() - 1, static_cast<size_t>(q * samples.size()))]; };
+
+        uint64_t sum = 0;
+        for (auto i : samples)
+            sum += i;
+
+        ret.mean = sum / samples.size();
+        ret.p50 = at(0.5);
+        ret.p99 = at(0.99);
+        ret.p999 = at(0.999);
+        ret.max = samples.back();
+        return ret;
+    }
+
+    std::string json() const
+    {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "{\"count\": %lu, \"mean\": %lu, \"p50\": %lu, \"p99\": %lu, \"p999\": %lu, \"max\": %lu}",
+                 count, mean, p50, p99, p999, max);
+        return buf;
+    }
+};
+
+struct result
+{
+    size_t producers;
+    std::string args;
+    std::string sink;
+    std::string overflow;
+    size_t written;
+    size_t dropped;
+    uint64_t backend_ns;
+    summary call;
+
+    double throughput() const
+    {
+        return backend_ns ? written * 1e9 / backend_ns : 0;
+    }
+
+    std::string json() const
+    {
+        char buf[512];
+        snprintf(buf, sizeof(buf), "{\"producers\": %lu, \"args\": \"%s\", \"sink\": \"%s\", \"overflow\": \"%s\", \"written\": %lu, \"dropped\": %lu, \"backend_ns\": %lu, \"throughput\": %.0f, \"call\": ",
+                 producers, args.c_str(), sink.c_str(), overflow.c_str(), written, dropped, backend_ns, throughput());
+        return buf + call.json() + "}";
+    }
+};
+
+//后端写入的输出 只计数, slow 时每条忙等模拟慢速 I/O
+class sink
+{
+private:
+    uint64_t delay_;
+    std::atomic<size_t> count_ = 0;
+    size_t bytes_ = 0;
+
+public:
+    sink(uint64_t delay) : delay_(delay) {}
+
+    void write(std::chrono::nanoseconds, std::string_view str)
+    {
+        if (delay_)
+        {
+            auto end = clock_type::now() + std::chrono::nanoseconds(delay_);
+            while (clock_type::now() < end)
+                ;
+        }
+        bytes_ += str.size();
+        count_.fetch_add(1, std::memory_order_release);
+    }
+
+    size_t count() const
+    {
+        return count_.load(std::memory_order_acquire);
+    }
+};
+
+class benchmark
+{
+public:
+    static uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+    }
+
+    static void call(log_type &log, sink &out, const std::string &args, size_t i, const std::string &str)
+    {
+        if (args == "int")
+            log(out, "{} {}\n", i, i * 3);
+        else if (args == "double")
+            log(out, "{:.3f} {}\n", i * 3.14, i * 8.25);
+        else if (args == "string")
+            log(out, "{} {}\n", str, std::string_view(str).substr(i % 8));
+        else
+            log(out, "{} {:.3f} {}\n", i, i * 3.14, str);
+    }
+
+    static result run_one(const options &opt, size_t producer_num, const std::string &args, const std::string &sink_name, const std::string &overflow_name)
+    {
+        auto overflow = overflow_name == "drop"   ? mio::logging::overflow::drop
+                        : overflow_name == "grow" ? mio::logging::overflow::grow
+                                                  : mio::logging::overflow::block;
+
+        size_t per_producer = opt.count / producer_num;
+        std::vector<std::vector<uint64_t>> samples(producer_num);
+        std::vector<size_t> dropped(producer_num);
+
+        sink out(sink_name == "slow" ? opt.slow_ns : 0);
+
+        std::thread backend([]()
+                            { log_type::run(); });
+
+        std::atomic<size_t> ready = 0;
+        std::atomic<bool> start = false;
+        std::atomic<size_t> done = 0;
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producer_num; p++)
+        {
+            threads.emplace_back([&, p]()
+                                 {
+                log_type log(overflow);
+                std::string str(32, 'a' + p % 26);
+                auto &list = samples[p];
+                list.reserve(per_producer);
+
+                ready++;
+                start.wait(false);
+
+                for (size_t i = 0; i < per_producer; i++)
+                {
+                    auto t0 = now();
+                    call(log, out, args, i, str);
+                    list.push_back(now() - t0);
+                }
+                dropped[p] = log.dropped();
+                done++;
+
+                //析构会丢弃未处理的消息 等待后端处理完
+                while (log.size())
+                    std::this_thread::yield(); });
+        }
+
+        while (ready != producer_num)
+            std::this_thread::yield();
+
+        auto begin = clock_type::now();
+        start = true;
+        start.notify_all();
+
+        //所有生产者结束后 等待后端输出全部未丢弃的消息
+        while (done != producer_num)
+            std::this_thread::yield();
+
+        size_t drop_count = 0;
+        for (auto i : dropped)
+            drop_count += i;
+
+        size_t expected = per_producer * producer_num - drop_count;
+        while (out.count() < expected)
+            std::this_thread::yield();
+        uint64_t backend_ns = (clock_type::now() - begin).count();
+
+        for (auto &th : threads)
+            th.join();
+
+        log_type::stop();
+        backend.join();
+
+        std::vector<uint64_t> all;
+        for (auto &i : samples)
+            all.insert(all.end(), i.begin(), i.end());
+
+        return {producer_num, args, sink_name, overflow_name, expected, drop_count, backend_ns, summary::make(all)};
+    }
+};
+
+std::vector<std::string> parse_names(const char *str)
+{
+    std::vector<std::string> ret;
+    std::string_view list(str);
+    while (!list.empty())
+    {
+        auto pos = list.find(',');
+        ret.emplace_back(list.substr(0, pos));
+        list = pos == std::string_view::npos ? std::string_view() : list.substr(pos + 1);
+    }
+    return ret;
+}
+
+std::vector<size_t> parse_list(const char *str)
+{
+    std::vector<size_t> ret;
+    for (auto &i : parse_names(str))
+        ret.push_back(std::strtoull(i.c_str(), nullptr, 10));
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    options opt;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string key = argv[i];
+        if (key == "--producers")
+            opt.producers = parse_list(argv[i + 1]);
+        else if (key == "--args")
+            opt.args = parse_names(argv[i + 1]);
+        else if (key == "--sinks")
+            opt.sinks = parse_names(argv[i + 1]);
+        else if (key == "--overflow")
+            opt.overflow = parse_names(argv[i + 1]);
+        else if (key == "--count")
+            opt.count = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (key == "--slow-ns")
+            opt.slow_ns = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (key == "--output")
+            opt.output = argv[i + 1];
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    for (auto &i : opt.args)
+    {
+        if (i != "int" && i != "double" && i != "string" && i != "mixed")
+        {
+            fprintf(stderr, "unknown args %s\n", i.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<result> results;
+    printf("%-4s %-7s %-5s %-6s %-10s %-9s %-28s %s\n", "p", "args", "sink", "policy", "written", "dropped",
+           "call p50/p99/p999/max", "backend msg/s");
+
+    for (auto &args : opt.args)
+        for (auto &sink_name : opt.sinks)
+            for (auto &overflow : opt.overflow)
+                for (auto producer_num : opt.producers)
+                {
+                    auto ret = benchmark::run_one(opt, producer_num, args, sink_name, overflow);
+
+                    char call[64];
+                    snprintf(call, sizeof(call), "%lu/%lu/%lu/%lu", ret.call.p50, ret.call.p99, ret.call.p999, ret.call.max);
+                    printf("%-4lu %-7s %-5s %-6s %-10lu %-9lu %-28s %.0f\n", ret.producers, ret.args.c_str(), ret.sink.c_str(),
+                           ret.overflow.c_str(), ret.written, ret.dropped, call, ret.throughput());
+                    results.push_back(ret);
+                }
+
+    std::string json = "{\"benchmark\": \"log\", \"count\": " + std::to_string(opt.count) + ", \"slow_ns\": " + std::to_string(opt.slow_ns) +
+                       ", \"unit\": \"ns\", \"results\": [";
+    for (size_t i = 0; i < results.size(); i++)
+        json += (i ? ",\n  " : "\n  ") + results[i].json();
+    json += "\n]}\n";
+
+    FILE *file = fopen(opt.output.c_str(), "w");
+    if (!file)
+    {
+        fprintf(stderr, "can not open %s\n", opt.output.c_str());
+        return 1;
+    }
+    fputs(json.c_str(), file);
+    fclose(file);
+    return 0;
+}
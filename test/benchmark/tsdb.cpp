@@ -0,0 +1,332 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mio/tsdb.hpp>
+
+/**
+ * tsdb 基准测试
+ *
+ * 覆盖 写线程数 x 读线程数 x 行大小 x 初始容量, 统计 push 延迟与可见延迟(写入开始到读者看到)的分位数,
+ * 触发 remap 的操作单独统计. 结果打印到终端, 并以 json 写入 --output 指定的文件
+ *
+ * 用法: tsdb_benchmark [--writers 1,2] [--readers 1,2] [--sizes 64,256,1024] [--capacity 4096,1048576]
+ *                      [--count 1000000] [--path tsdb_benchmark.db] [--output tsdb_benchmark.json]
+ */
+
+using clock_type = std::chrono::steady_clock;
+
+struct options
+{
+    std::vector<size_t> writers = {1, 2};
+    std::vector<size_t> readers = {1, 2};
+    std::vector<size_t> sizes = {64, 256, 1024};
+    std::vector<size_t> capacity = {4096, 1048576};
+    size_t count = 1000000;
+    std::string path = "tsdb_benchmark.db";
+    std::string output = "tsdb_benchmark.json";
+};
+
+struct summary
+{
+    size_t count = 0;
+    uint64_t mean = 0;
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+
+    static summary make(std::vector<uint64_t> &samples)
+    {
+        summary ret;
+        ret.count = samples.size();
+        if (samples.empty())
+            return ret;
+
+        std::sort(samples.begin(), samples.end());
+        auto at = [&](double q)
+        { return samples[std::min(samples.size() - 1, static_cast<size_t>(q * samples.size()))]; };
+
+        uint64_t sum = 0;
+        for (auto i : samples)
+            sum += i;
+
+        ret.mean = sum / samples.size();
+        ret.p50 = at(0.5);
+        ret.p99 = at(0.99);
+        ret.p999 = at(0.999);
+        ret.max = samples.back();
+        return ret;
+    }
+
+    std::string json() const
+    {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "{\"count\": %lu, \"mean\": %lu, \"p50\": %lu, \"p99\": %lu, \"p999\": %lu, \"max\": %lu}",
+                 count, mean, p50, p99, p999, max);
+        return buf;
+    }
+};
+
+struct result
+{
+    size_t writers;
+    size_t readers;
+    size_t row_size;
+    size_t capacity;
+    uint64_t write_ns;
+    uint64_t read_ns;
+    summary push;
+    summary push_remap;
+    summary visibility;
+    summary visibility_remap;
+    mio::tsdb::statistics stat;
+
+    std::string json() const
+    {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "{\"writers\": %lu, \"readers\": %lu, \"row_size\": %lu, \"capacity\": %lu, \"write_ns_per_op\": %lu, \"read_ns_per_op\": %lu, ",
+                 writers, readers, row_size, capacity, write_ns, read_ns);
+        std::string ret = buf + ("\"push\": " + push.json() + ", \"push_remap\": " + push_remap.json() +
+                                 ", \"visibility\": " + visibility.json() + ", \"visibility_remap\": " + visibility_remap.json());
+        snprintf(buf, sizeof(buf), ", \"statistics\": {\"recapacity\": %lu, \"remap\": %lu, \"capacity_wait\": %lu, \"row_wait\": %lu, \"remap_ns\": %lu}}",
+                 stat.recapacity, stat.remap, stat.capacity_wait, stat.row_wait, stat.remap_ns);
+        return ret + buf;
+    }
+};
+
+class benchmark
+{
+public:
+    template <size_t DATA_SIZE>
+    struct value
+    {
+        uint64_t time;
+        size_t val;
+        char _[DATA_SIZE - sizeof(time) - sizeof(val)];
+    };
+
+    static uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+    }
+
+    template <size_t DATA_SIZE>
+    static result run_one(const options &opt, size_t writer_num, size_t reader_num, size_t capacity)
+    {
+        using value = value<DATA_SIZE>;
+
+        size_t per_writer = opt.count / writer_num;
+        size_t total = per_writer * writer_num;
+
+        std::vector<std::vector<uint64_t>> push(writer_num), push_remap(writer_num);
+        std::vector<std::vector<uint64_t>> visibility(reader_num), visibility_remap(reader_num);
+        std::vector<uint64_t> write_diff(writer_num), read_diff(reader_num);
+
+        mio::tsdb::table<value> table(opt.path, capacity);
+
+        std::atomic<size_t> ready = 0;
+        std::atomic<bool> start = false;
+
+        std::vector<std::thread> write_thread, read_thread;
+
+        for (size_t w = 0; w < writer_num; w++)
+        {
+            write_thread.emplace_back([&, w]()
+                                      {
+                mio::tsdb::table<value> table(opt.path);
+                auto &samples = push[w];
+                auto &remap_samples = push_remap[w];
+                samples.reserve(per_writer);
+
+                ready++;
+                start.wait(false);
+
+                value data;
+                size_t local_capacity = table.capacity();
+
+                auto begin = clock_type::now();
+                for (size_t i = 0; i < per_writer; i++)
+                {
+                    data.val = w * per_writer + i;
+                    auto t0 = now();
+                    data.time = t0;
+                    auto index = table.push(data);
+                    auto t1 = now();
+
+                    //与 table::do_push 相同的判断 该次 push 触发了 remap
+                    if (index >= local_capacity)
+                    {
+                        remap_samples.push_back(t1 - t0);
+                        local_capacity = table.capacity();
+                    }
+                    else
+                    {
+                        samples.push_back(t1 - t0);
+                    }
+                }
+                write_diff[w] = (clock_type::now() - begin).count(); });
+        }
+
+        for (size_t r = 0; r < reader_num; r++)
+        {
+            read_thread.emplace_back([&, r]()
+                                     {
+                mio::tsdb::table<value> table(opt.path);
+                auto &samples = visibility[r];
+                auto &remap_samples = visibility_remap[r];
+                samples.reserve(total);
+
+                ready++;
+                start.wait(false);
+
+                size_t local_capacity = table.capacity();
+
+                auto begin = clock_type::now();
+                for (size_t i = 0; i < total; i++)
+                {
+                    bool remap = i >= local_capacity;
+                    auto &row = table.wait(i);
+                    auto diff = now() - row->time;
+
+                    if (remap)
+                    {
+                        remap_samples.push_back(diff);
+                        local_capacity = table.capacity();
+                    }
+                    else
+                    {
+                        samples.push_back(diff);
+                    }
+                }
+                read_diff[r] = (clock_type::now() - begin).count(); });
+        }
+
+        while (ready != writer_num + reader_num)
+            std::this_thread::yield();
+
+        start = true;
+        start.notify_all();
+
+        for (auto &th : write_thread)
+            th.join();
+
+        for (auto &th : read_thread)
+            th.join();
+
+        auto merge = [](std::vector<std::vector<uint64_t>> &list)
+        {
+            std::vector<uint64_t> ret;
+            for (auto &i : list)
+                ret.insert(ret.end(), i.begin(), i.end());
+            return ret;
+        };
+
+        auto push_all = merge(push), push_remap_all = merge(push_remap);
+        auto visibility_all = merge(visibility), visibility_remap_all = merge(visibility_remap);
+
+        return {writer_num, reader_num, DATA_SIZE, capacity,
+                *std::max_element(write_diff.begin(), write_diff.end()) / per_writer,
+                *std::max_element(read_diff.begin(), read_diff.end()) / total,
+                summary::make(push_all), summary::make(push_remap_all),
+                summary::make(visibility_all), summary::make(visibility_remap_all), table.stat()};
+    }
+
+    template <size_t... DATA_SIZE>
+    static bool run(const options &opt, size_t row_size, size_t writer_num, size_t reader_num, size_t capacity, result &ret)
+    {
+        return ((row_size == DATA_SIZE ? (ret = run_one<DATA_SIZE>(opt, writer_num, reader_num, capacity), true) : false) || ...);
+    }
+};
+
+std::vector<size_t> parse_list(const char *str)
+{
+    std::vector<size_t> ret;
+    for (const char *p = str; *p;)
+    {
+        char *end;
+        ret.push_back(std::strtoull(p, &end, 10));
+        p = *end == ',' ? end + 1 : end;
+        if (end == p && *p)
+            break;
+    }
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    options opt;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string key = argv[i];
+        if (key == "--writers")
+            opt.writers = parse_list(argv[i + 1]);
+        else if (key == "--readers")
+            opt.readers = parse_list(argv[i + 1]);
+        else if (key == "--sizes")
+            opt.sizes = parse_list(argv[i + 1]);
+        else if (key == "--capacity")
+            opt.capacity = parse_list(argv[i + 1]);
+        else if (key == "--count")
+            opt.count = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (key == "--path")
+            opt.path = argv[i + 1];
+        else if (key == "--output")
+            opt.output = argv[i + 1];
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::vector<result> results;
+    printf("%-4s %-4s %-6s %-9s %-8s %-8s %-28s %-28s %s\n", "w", "r", "size", "capacity", "w/ns", "r/ns",
+           "push p50/p99/p999/max", "visible p50/p99/p999/max", "remap count/max");
+
+    for (auto size : opt.sizes)
+        for (auto capacity : opt.capacity)
+            for (auto writer_num : opt.writers)
+                for (auto reader_num : opt.readers)
+                {
+                    result ret;
+                    if (!benchmark::run<64, 128, 256, 512, 1024, 4096>(opt, size, writer_num, reader_num, capacity, ret))
+                    {
+                        fprintf(stderr, "unsupported row size %lu\n", size);
+                        return 1;
+                    }
+
+                    char push[64], visible[64];
+                    snprintf(push, sizeof(push), "%lu/%lu/%lu/%lu", ret.push.p50, ret.push.p99, ret.push.p999, ret.push.max);
+                    snprintf(visible, sizeof(visible), "%lu/%lu/%lu/%lu", ret.visibility.p50, ret.visibility.p99, ret.visibility.p999, ret.visibility.max);
+                    printf("%-4lu %-4lu %-6lu %-9lu %-8lu %-8lu %-28s %-28s %lu/%lu\n", ret.writers, ret.readers, ret.row_size, ret.capacity,
+                           ret.write_ns, ret.read_ns, push, visible, ret.push_remap.count, ret.push_remap.max);
+                    results.push_back(ret);
+                }
+
+    std::string json = "{\"benchmark\": \"tsdb\", \"count\": " + std::to_string(opt.count) + ", \"unit\": \"ns\", \"results\": [";
+    for (size_t i = 0; i < results.size(); i++)
+        json += (i ? ",\n  " : "\n  ") + results[i].json();
+    json += "\n]}\n";
+
+    FILE *file = fopen(opt.output.c_str(), "w");
+    if (!file)
+    {
+        fprintf(stderr, "can not open %s\n", opt.output.c_str());
+        return 1;
+    }
+    fputs(json.c_str(), file);
+    fclose(file);
+
+    std::remove(opt.path.c_str());
+    return 0;
+}
@@ -1,7 +1,15 @@
 #include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
 #include <thread>
 #include <queue>
 #include <string>
+#include <sstream>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include <mio/log.hpp>
 #include <gtest/gtest.h>
@@ -26,6 +34,11 @@ public:
         queue_.pop();
         return ret;
     }
+
+    size_t size() const
+    {
+        return queue_.size();
+    }
 };
 
 TEST(log, log)
@@ -57,6 +70,533 @@ TEST(log, log)
     }
 }
 
+TEST(log, binary)
+{
+    mio::log LOG;
+
+    std::thread th([&]()
+                   { decltype(LOG)::run(); });
+
+    std::stringstream buffer;
+    mio::logging::binary_sink sink(buffer);
+
+    auto start = mio::chrono::now();
+    for (size_t i = 0; i < SIZE; i++)
+    {
+        LOG(sink, "{} {} {}\n", i, std::to_string(i * 3.14), i * 8.25);
+    }
+    auto end = mio::chrono::now();
+
+    printf("size/%lu ns/%lu \n", SIZE, (end - start).count() / SIZE);
+    while (LOG.size())
+        ;
+
+    decltype(LOG)::stop();
+    th.join();
+
+    size_t i = 0;
+    mio::logging::binary_decoder decoder;
+    auto count = decoder.decode(buffer, [&](std::string_view str)
+                                {
+        GTEST_ASSERT_EQ(str, fmt::format("{} {} {}\n", i, std::to_string(i * 3.14), i * 8.25));
+        i++; });
+    GTEST_ASSERT_EQ(count, SIZE);
+}
+
+TEST(log, compile)
+{
+    mio::log LOG;
+
+    std::thread th([&]()
+                   { decltype(LOG)::run(); });
+
+    stream stream_;
+    std::stringstream buffer;
+    mio::logging::binary_sink sink(buffer);
+
+    auto start = mio::chrono::now();
+    for (size_t i = 0; i < SIZE; i++)
+    {
+        LOG(stream_, FMT_COMPILE("{} {:.3f} {}\n"), i, i * 3.14, i * 8.25);
+        LOG(sink, FMT_COMPILE("{} {:.3f} {}\n"), i, i * 3.14, i * 8.25);
+    }
+    LOG(stream_, "{} literal\n", SIZE);
+    auto end = mio::chrono::now();
+
+    printf("size/%lu ns/%lu \n", SIZE, (end - start).count() / SIZE / 2);
+    while (LOG.size())
+        ;
+
+    decltype(LOG)::stop();
+    th.join();
+
+    for (size_t i = 0; i < SIZE; i++)
+    {
+        GTEST_ASSERT_EQ(stream_.pop(), fmt::format("{} {:.3f} {}\n", i, i * 3.14, i * 8.25));
+    }
+    GTEST_ASSERT_EQ(stream_.pop(), fmt::format("{} literal\n", SIZE));
+
+    size_t i = 0;
+    mio::logging::binary_decoder decoder;
+    decoder.decode(buffer, [&](std::string_view str)
+                   {
+        GTEST_ASSERT_EQ(str, fmt::format("{} {:.3f} {}\n", i, i * 3.14, i * 8.25));
+        i++; });
+    GTEST_ASSERT_EQ(i, SIZE);
+}
+
+TEST(log, level)
+{
+    mio::log LOG;
+
+    std::thread th([&]()
+                   { decltype(LOG)::run(); });
+
+    stream stream_;
+    size_t count = 0;
+    auto eval = [&]()
+    { return ++count; };
+
+    LOG.set_level(mio::logging::level::warn);
+    LOG.info(stream_, "{} info\n", 1);
+    LOG.warn(stream_, "{} warn\n", 2);
+    LOG.error(stream_, std::string_view("{} error\n"), 3);
+    MIO_LOG_DEBUG(LOG, stream_, "{} debug\n", eval());
+    MIO_LOG_CRITICAL(LOG, stream_, "{} critical\n", eval());
+
+    LOG.set_level(mio::logging::level::off);
+    LOG.critical(stream_, "{} off\n", 4);
+
+    while (LOG.size())
+        ;
+
+    decltype(LOG)::stop();
+    th.join();
+
+    GTEST_ASSERT_EQ(count, 1);
+    GTEST_ASSERT_EQ(stream_.pop(), "2 warn\n");
+    GTEST_ASSERT_EQ(stream_.pop(), "3 error\n");
+    GTEST_ASSERT_EQ(stream_.pop(), "1 critical\n");
+    GTEST_ASSERT_EQ(stream_.size(), 0);
+}
+
+TEST(log, string)
+{
+    mio::log<4096> LOG;
+
+    std::thread th([&]()
+                   { decltype(LOG)::run(); });
+
+    stream stream_;
+    std::string str = "string";
+    std::string_view view = "view";
+    const char *ptr = "pointer";
+    char buf[] = "buffer";
+    std::string large(3000, 'x');
+
+    LOG(stream_, "{} {} {} {} {} {}\n", str, view, ptr, buf, "literal", mio::logging::static_string("static"));
+    LOG(stream_, FMT_COMPILE("{} {} {}\n"), str, std::string_view(), mio::logging::static_string(view));
+    LOG(stream_, "{}\n", large);
+
+    //参数已内联拷贝 调用后修改不影响输出
+    str = "changed";
+    buf[0] = 'B';
+
+    while (LOG.size())
+        ;
+
+    decltype(LOG)::stop();
+    th.join();
+
+    GTEST_ASSERT_EQ(stream_.pop(), "string view pointer buffer literal static\n");
+    GTEST_ASSERT_EQ(stream_.pop(), "string  view\n");
+    GTEST_ASSERT_EQ(stream_.pop(), large + "\n");
+    GTEST_ASSERT_EQ(stream_.size(), 0);
+}
+
+TEST(log, kv)
+{
+    mio::log LOG;
+
+    std::thread th([&]()
+                   { decltype(LOG)::run(); });
+
+    enum class side : int8_t
+    {
+        buy = 1,
+        sell = -1,
+    };
+
+    stream stream_;
+    std::string symbol = "IF 2212";
+    LOG.kv(stream_, "order", "id", 42, "px", 3.25, "side", side::sell, "symbol", symbol, "ok", true);
+    LOG.kv(stream_, "quote", "msg", "say \"hi\"\n", "nan", std::nan(""));
+    LOG.kv(stream_, "empty");
+
+    LOG.set_kv_format(mio::logging::kv_format::logfmt);
+    LOG.kv(stream_, "order", "id", 42u, "px", 3.25f, "side", side::buy, "symbol", symbol, "ok", false);
+    LOG.kv(stream_, "quote", "msg", std::string_view("a=b"), "empty", "", "c", 'x');
+
+    while (LOG.size())
+        ;
+
+    decltype(LOG)::stop();
+    th.join();
+
+    GTEST_ASSERT_EQ(stream_.pop(), "{\"event\":\"order\",\"id\":42,\"px\":3.25,\"side\":-1,\"symbol\":\"IF 2212\",\"ok\":true}\n");
+    GTEST_ASSERT_EQ(stream_.pop(), "{\"event\":\"quote\",\"msg\":\"say \\\"hi\\\"\\n\",\"nan\":null}\n");
+    GTEST_ASSERT_EQ(stream_.pop(), "{\"event\":\"empty\"}\n");
+    GTEST_ASSERT_EQ(stream_.pop(), "event=order id=42 px=3.25 side=1 symbol=\"IF 2212\" ok=false\n");
+    GTEST_ASSERT_EQ(stream_.pop(), "event=quote msg=\"a=b\" empty=\"\" c=x\n");
+    GTEST_ASSERT_EQ(stream_.size(), 0);
+}
+
+TEST(log, overflow)
+{
+    constexpr size_t COUNT = 10000;
+
+    mio::log<4096> drop(mio::logging::overflow::drop), grow(mio::logging::overflow::grow);
+    stream drop_stream, grow_stream;
+
+    //后端未启动 drop 写满后丢弃, grow 链接新缓冲区
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        drop(drop_stream, "{}\n", i);
+        grow(grow_stream, "{}\n", i);
+    }
+    GTEST_ASSERT_GT(drop.dropped(), 0);
+    GTEST_ASSERT_EQ(grow.dropped(), 0);
+
+    //超过缓冲区大小的消息
+    std::stringstream buffer;
+    mio::logging::binary_sink sink(buffer);
+    std::string large(10000, 'x');
+    grow(sink, "{}", large);
+
+    std::thread th([&]()
+                   { decltype(grow)::run(); });
+
+    while (drop.size() || grow.size())
+        ;
+
+    decltype(grow)::stop();
+    th.join();
+
+    GTEST_ASSERT_EQ(drop_stream.size() + drop.dropped(), COUNT);
+    for (size_t i = 0; drop_stream.size(); i++)
+        GTEST_ASSERT_EQ(drop_stream.pop(), fmt::format("{}\n", i));
+
+    for (size_t i = 0; i < COUNT; i++)
+        GTEST_ASSERT_EQ(grow_stream.pop(), fmt::format("{}\n", i));
+
+    mio::logging::binary_decoder decoder;
+    auto count = decoder.decode(buffer, [&](std::string_view str)
+                                { GTEST_ASSERT_EQ(str, large); });
+    GTEST_ASSERT_EQ(count, 1);
+}
+
+TEST(log, local)
+{
+    constexpr size_t THREAD = 64;
+    constexpr size_t ROUND = 8;
+    constexpr size_t COUNT = 100;
+
+    std::thread th([&]()
+                   { mio::log<>::run(); });
+
+    std::vector<stream> streams(THREAD * ROUND);
+    for (size_t r = 0; r < ROUND; r++)
+    {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREAD; t++)
+        {
+            threads.emplace_back([&, index = r * THREAD + t]()
+                                 {
+                for (size_t i = 0; i < COUNT; i++)
+                    mio::log<>::local()(streams[index], "{} {}\n", index, i); });
+        }
+
+        for (auto &i : threads)
+            i.join();
+    }
+
+    mio::log<>::stop();
+    th.join();
+
+    for (size_t index = 0; index < streams.size(); index++)
+    {
+        GTEST_ASSERT_EQ(streams[index].size(), COUNT);
+        for (size_t i = 0; i < COUNT; i++)
+            GTEST_ASSERT_EQ(streams[index].pop(), fmt::format("{} {}\n", index, i));
+    }
+}
+
+TEST(log, time)
+{
+    struct timed_stream
+    {
+        std::vector<std::chrono::nanoseconds> time;
+
+        void write(std::chrono::nanoseconds time, std::string_view)
+        {
+            this->time.push_back(time);
+        }
+    };
+
+    mio::log LOG;
+
+    std::thread th([&]()
+                   { decltype(LOG)::run(); });
+
+    timed_stream stream_;
+    std::stringstream buffer;
+    mio::logging::binary_sink sink(buffer);
+
+    auto start = mio::chrono::now();
+    for (size_t i = 0; i < 1000; i++)
+    {
+        LOG(stream_, "{}", i);
+        LOG(sink, "{}", i);
+    }
+    auto end = mio::chrono::now();
+
+    while (LOG.size())
+        ;
+
+    decltype(LOG)::stop();
+    th.join();
+
+    //校准误差 允许 1ms
+    auto check = [&](std::chrono::nanoseconds time)
+    {
+        GTEST_ASSERT_GE(time, start - std::chrono::milliseconds(1));
+        GTEST_ASSERT_LE(time, end + std::chrono::milliseconds(1));
+    };
+
+    GTEST_ASSERT_EQ(stream_.time.size(), 1000);
+    for (size_t i = 0; i < stream_.time.size(); i++)
+    {
+        check(stream_.time[i]);
+        if (i)
+        {
+            GTEST_ASSERT_GE(stream_.time[i], stream_.time[i - 1]);
+        }
+    }
+
+    mio::logging::binary_decoder decoder;
+    auto count = decoder.decode(buffer, [&](std::chrono::nanoseconds time, std::string_view)
+                                { check(time); });
+    GTEST_ASSERT_EQ(count, 1000);
+}
+
+TEST(log, order)
+{
+    constexpr size_t THREAD = 4;
+    constexpr size_t COUNT = 10000;
+
+    struct timed_stream
+    {
+        std::vector<std::pair<std::chrono::nanoseconds, std::string>> list;
+
+        void write(std::chrono::nanoseconds time, std::string_view str)
+        {
+            list.emplace_back(time, str);
+        }
+    };
+
+    mio::log<>::set_order(true, std::chrono::milliseconds(50));
+    std::thread th([&]()
+                   { mio::log<>::run(); });
+
+    timed_stream stream_;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREAD; t++)
+    {
+        threads.emplace_back([&, t]()
+                             {
+            for (size_t i = 0; i < COUNT; i++)
+                mio::log<>::local()(stream_, "{} {}", t, i); });
+    }
+
+    for (auto &i : threads)
+        i.join();
+
+    mio::log<>::stop();
+    th.join();
+    mio::log<>::set_order(false);
+
+    GTEST_ASSERT_EQ(stream_.list.size(), THREAD * COUNT);
+    std::vector<size_t> next(THREAD, 0);
+    for (size_t i = 0; i < stream_.list.size(); i++)
+    {
+        if (i)
+        {
+            GTEST_ASSERT_GE(stream_.list[i].first, stream_.list[i - 1].first);
+        }
+
+        //同一线程内 保持写入顺序
+        size_t t, n;
+        std::sscanf(stream_.list[i].second.c_str(), "%lu %lu", &t, &n);
+        GTEST_ASSERT_EQ(n, next[t]++);
+    }
+}
+
+TEST(log, shard)
+{
+    constexpr size_t SHARDS = 4;
+    constexpr size_t THREAD = 8;
+    constexpr size_t COUNT = 10000;
+    using log_type = mio::log<8192>;
+
+    log_type::set_shards(SHARDS);
+    GTEST_ASSERT_EQ(log_type::shards(), SHARDS);
+
+    //每个分片使用各自的输出
+    std::vector<stream> streams(SHARDS);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < SHARDS; i++)
+        workers.emplace_back([i]()
+                             { log_type::run_shard(i); });
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREAD; t++)
+    {
+        threads.emplace_back([&, t]()
+                             {
+            auto &log = log_type::local();
+            for (size_t i = 0; i < COUNT; i++)
+                log(streams[log.shard()], "{} {}", t, i); });
+    }
+
+    for (auto &i : threads)
+        i.join();
+
+    log_type::stop();
+    for (auto &i : workers)
+        i.join();
+
+    std::vector<size_t> next(THREAD, 0);
+    size_t total = 0;
+    for (auto &stream_ : streams)
+    {
+        total += stream_.size();
+        while (stream_.size())
+        {
+            size_t t, n;
+            std::sscanf(stream_.pop().c_str(), "%lu %lu", &t, &n);
+            GTEST_ASSERT_EQ(n, next[t]++);
+        }
+    }
+    GTEST_ASSERT_EQ(total, THREAD * COUNT);
+}
+
+TEST(log, file_sink)
+{
+    constexpr size_t COUNT = 100000;
+
+    std::string path = "log_file_sink.log";
+    auto remove = [&]()
+    {
+        for (auto &i : std::filesystem::directory_iterator("."))
+        {
+            if (i.path().filename().string().starts_with(path))
+                std::filesystem::remove(i.path());
+        }
+    };
+    remove();
+
+    {
+        mio::log LOG;
+        mio::logging::file_options options;
+        options.buffer_size = 64 << 10;
+        options.chunk_size = 4096;
+        options.rotate_size = 1 << 20;
+        mio::logging::file_sink sink(path, options);
+
+        std::thread th([&]()
+                       { decltype(LOG)::run(); });
+
+        for (size_t i = 0; i < COUNT; i++)
+            LOG(sink, "{} {}\n", i, i * 8.25);
+
+        while (LOG.size())
+            ;
+
+        decltype(LOG)::stop();
+        th.join();
+    }
+
+    //轮换出的文件名按时间与序号排序 当前文件最后
+    std::vector<std::string> files;
+    for (auto &i : std::filesystem::directory_iterator("."))
+    {
+        auto name = i.path().filename().string();
+        if (name.starts_with(path + "."))
+            files.push_back(name);
+    }
+    std::sort(files.begin(), files.end(), [](const std::string &a, const std::string &b)
+              { return std::stoul(a.substr(a.rfind('.') + 1)) < std::stoul(b.substr(b.rfind('.') + 1)); });
+    files.push_back(path);
+    GTEST_ASSERT_GT(files.size(), 2);
+
+    size_t i = 0;
+    for (auto &name : files)
+    {
+        GTEST_ASSERT_LE(std::filesystem::file_size(name), (1 << 20) + (64 << 10));
+
+        std::ifstream file(name);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            //日期 时间.纳秒 内容
+            auto pos = line.find(' ', line.find(' ') + 1);
+            GTEST_ASSERT_EQ(line.substr(pos + 1), fmt::format("{} {}", i, i * 8.25));
+            i++;
+        }
+    }
+    GTEST_ASSERT_EQ(i, COUNT);
+    remove();
+}
+
+TEST(log, shm_recover)
+{
+    constexpr size_t COUNT = 1000;
+    std::string name = "mio_log_shm_recover";
+    boost::interprocess::shared_memory_object::remove(name.c_str());
+
+    //子进程写入后直接退出 不运行后端, 模拟崩溃
+    auto pid = fork();
+    if (pid == 0)
+    {
+        mio::logging::shm_segment segment(name, 4 << 20);
+        mio::log LOG(segment, mio::logging::overflow::grow);
+
+        std::stringstream buffer;
+        mio::logging::binary_sink sink(buffer);
+        stream stream_;
+        for (size_t i = 0; i < COUNT; i++)
+        {
+            LOG(sink, "{} {} {}\n", i, std::to_string(i * 3.14), i * 8.25);
+            LOG(stream_, "{} text\n", i);
+        }
+        std::_Exit(0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+
+    std::stringstream buffer;
+    GTEST_ASSERT_EQ(mio::logging::shm_recover(name, buffer), COUNT);
+    boost::interprocess::shared_memory_object::remove(name.c_str());
+
+    size_t i = 0;
+    mio::logging::binary_decoder decoder;
+    decoder.decode(buffer, [&](std::string_view str)
+                   {
+        GTEST_ASSERT_EQ(str, fmt::format("{} {} {}\n", i, std::to_string(i * 3.14), i * 8.25));
+        i++; });
+    GTEST_ASSERT_EQ(i, COUNT);
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
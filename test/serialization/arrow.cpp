@@ -0,0 +1,110 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+#include <mio/tsdb.hpp>
+#include <mio/serialization/arrow.hpp>
+
+constexpr size_t COUNT = 100000;
+
+constexpr size_t BUFFER_SIZE = 4096;
+
+struct tick
+{
+    std::chrono::nanoseconds time;
+    double price;
+    std::int32_t volume;
+    bool buy;
+    char symbol[8];
+};
+
+std::vector<mio::serialization::arrow_field<tick>> fields()
+{
+    return {{"time", &tick::time}, {"price", &tick::price}, {"volume", &tick::volume}, {"buy", &tick::buy}, {"symbol", &tick::symbol}};
+}
+
+tick make_tick(size_t i)
+{
+    tick ret{std::chrono::nanoseconds(i * 1000), i * 0.25, static_cast<std::int32_t>(i), i % 3 == 0, "IF2203"};
+    ret.symbol[7] = static_cast<char>(i % 128);
+    return ret;
+}
+
+void verify(mio::tsdb::table<tick> &table)
+{
+    ASSERT_EQ(table.size(), COUNT);
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        auto val = make_tick(i);
+        auto &row = table[i].value();
+        ASSERT_EQ(row.time, val.time);
+        ASSERT_EQ(row.price, val.price);
+        ASSERT_EQ(row.volume, val.volume);
+        ASSERT_EQ(row.buy, val.buy);
+        ASSERT_EQ(std::memcmp(row.symbol, val.symbol, sizeof(val.symbol)), 0);
+    }
+}
+
+TEST(arrow, columns)
+{
+    mio::tsdb::table<tick> src("arrow_src.db", BUFFER_SIZE);
+    for (size_t i = 0; i < COUNT; i++)
+        src.push(make_tick(i));
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::ofstream file("arrow_columns.arrow", std::ios::binary);
+        ASSERT_EQ(mio::serialization::arrow_dump(file, src, 0, src.size(), fields(), 30000), COUNT);
+    }
+    auto end = std::chrono::steady_clock::now();
+    printf("dump columns ns/%lu\n", (end - start).count() / COUNT);
+
+    mio::tsdb::table<tick> dst("arrow_dst.db", BUFFER_SIZE);
+    std::ifstream file("arrow_columns.arrow", std::ios::binary);
+    ASSERT_EQ(mio::serialization::arrow_load(file, dst, fields()), COUNT);
+    verify(dst);
+}
+
+TEST(arrow, raw)
+{
+    mio::tsdb::table<tick> src("arrow_src.db", BUFFER_SIZE);
+    for (size_t i = 0; i < COUNT; i++)
+        src.push(make_tick(i));
+
+    auto start = std::chrono::steady_clock::now();
+    std::stringstream stream;
+    ASSERT_EQ(mio::serialization::arrow_dump(stream, src, 0, src.size()), COUNT);
+    auto end = std::chrono::steady_clock::now();
+    printf("dump raw ns/%lu\n", (end - start).count() / COUNT);
+
+    mio::tsdb::table<tick> dst("arrow_dst.db", BUFFER_SIZE);
+    ASSERT_EQ(mio::serialization::arrow_load(stream, dst), COUNT);
+    verify(dst);
+}
+
+TEST(arrow, mismatch)
+{
+    struct other
+    {
+        float price;
+    };
+
+    mio::tsdb::table<tick> src("arrow_src.db", BUFFER_SIZE);
+    src.push(make_tick(0));
+
+    std::stringstream stream;
+    mio::serialization::arrow_dump(stream, src, 0, src.size(), fields());
+
+    mio::tsdb::table<other> dst("arrow_dst.db", BUFFER_SIZE);
+    ASSERT_THROW(mio::serialization::arrow_load(stream, dst, {{"price", &other::price}}), std::runtime_error);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,178 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <mio/tsdb.hpp>
+#include <mio/serialization/binary.hpp>
+
+constexpr size_t COUNT = 100000;
+
+namespace market
+{
+    struct tick
+    {
+        std::chrono::nanoseconds time;
+        double price;
+        std::int32_t volume;
+        bool buy;
+        char symbol[8];
+    };
+
+    MIO_REFLECT(tick, time, price, volume, buy, symbol)
+
+    //新版本: 调整顺序, volume 变宽, time 改为微秒, symbol 变长, 删除 buy, 增加 bid
+    struct tick_v2
+    {
+        char symbol[12];
+        std::int64_t volume;
+        std::chrono::microseconds time;
+        double price;
+        float bid;
+    };
+
+    MIO_REFLECT(tick_v2, symbol, volume, time, price, bid)
+
+    struct tick_bad
+    {
+        double symbol;
+    };
+
+    MIO_REFLECT(tick_bad, symbol)
+} // namespace market
+
+using market::tick;
+
+tick make_tick(size_t i)
+{
+    tick ret{std::chrono::nanoseconds(i * 1000), i * 0.25, static_cast<std::int32_t>(i) - 100, i % 3 == 0, "IF"};
+    snprintf(ret.symbol, sizeof(ret.symbol), "IF%lu", i % 10000);
+    return ret;
+}
+
+void verify(const tick &row, size_t i)
+{
+    auto val = make_tick(i);
+    ASSERT_EQ(row.time, val.time);
+    ASSERT_EQ(row.price, val.price);
+    ASSERT_EQ(row.volume, val.volume);
+    ASSERT_EQ(row.buy, val.buy);
+    ASSERT_EQ(std::memcmp(row.symbol, val.symbol, sizeof(val.symbol)), 0);
+}
+
+TEST(binary, schema)
+{
+    auto schema = mio::serialization::binary_schema::make<tick>(3);
+    ASSERT_EQ(schema.version, 3);
+    ASSERT_EQ(schema.record_size, sizeof(tick));
+    ASSERT_EQ(schema.columns.size(), 5);
+    ASSERT_EQ(schema.columns[0].type, mio::serialization::binary_type::duration);
+    ASSERT_EQ(schema.columns[0].den, 1000000000);
+    ASSERT_EQ(schema.columns[2].offset, offsetof(tick, volume));
+    ASSERT_EQ(schema.columns[4].type, mio::serialization::binary_type::string);
+
+    auto header = schema.encode();
+    ASSERT_EQ(header.size() % 64, 0);
+
+    size_t offset = 0;
+    ASSERT_FALSE(mio::serialization::binary_schema::decode(header.data(), 16, offset));
+    ASSERT_FALSE(mio::serialization::binary_schema::decode(header.data(), 40, offset));
+    ASSERT_EQ(offset, header.size());
+
+    auto decoded = mio::serialization::binary_schema::decode(header.data(), header.size(), offset);
+    ASSERT_EQ(decoded->version, 3);
+    ASSERT_EQ(decoded->columns, schema.columns);
+
+    header[0] = 'X';
+    ASSERT_THROW(mio::serialization::binary_schema::decode(header.data(), header.size(), offset), std::runtime_error);
+}
+
+TEST(binary, view)
+{
+    mio::tsdb::table<tick> src("binary_src.db", 4096);
+    for (size_t i = 0; i < COUNT; i++)
+        src.push(make_tick(i));
+
+    {
+        std::ofstream file("binary_view.bin", std::ios::binary);
+        ASSERT_EQ(mio::serialization::binary_dump(file, src, 0, COUNT, 1), COUNT);
+    }
+
+    //布局一致 原地访问
+    auto start = std::chrono::steady_clock::now();
+    mio::serialization::binary_view<tick> view("binary_view.bin");
+    ASSERT_TRUE(view.identical());
+    ASSERT_EQ(view.size(), COUNT);
+    ASSERT_EQ(view.schema().version, 1);
+    double sum = 0;
+    for (auto &row : view)
+        sum += row.price;
+    auto end = std::chrono::steady_clock::now();
+    printf("view ns/%lu\n", (end - start).count() / COUNT);
+    ASSERT_EQ(sum, (COUNT - 1) * COUNT / 2 * 0.25);
+
+    for (size_t i = 0; i < COUNT; i++)
+        verify(view[i], i);
+    ASSERT_THROW(view.get(COUNT), std::out_of_range);
+
+    //流式读回 tsdb
+    std::ifstream file("binary_view.bin", std::ios::binary);
+    mio::tsdb::table<tick> dst("binary_dst.db", 4096);
+    ASSERT_EQ(mio::serialization::binary_load(file, dst), COUNT);
+    for (size_t i = 0; i < COUNT; i++)
+        verify(dst[i].value(), i);
+
+    std::remove("binary_view.bin");
+}
+
+TEST(binary, evolution)
+{
+    std::stringstream stream;
+    {
+        mio::serialization::binary_writer<tick> writer(stream);
+        for (size_t i = 0; i < 1000; i++)
+            writer.write(make_tick(i));
+    }
+    auto str = stream.str();
+
+    //外部内存需要 64 字节对齐
+    std::vector<std::max_align_t> storage(str.size() / sizeof(std::max_align_t) + 64);
+    auto *data = reinterpret_cast<char *>((reinterpret_cast<std::uintptr_t>(storage.data()) + 63) / 64 * 64);
+    std::memcpy(data, str.data(), str.size());
+
+    mio::serialization::binary_view<market::tick_v2> view(data, str.size());
+    ASSERT_FALSE(view.identical());
+    ASSERT_EQ(view.size(), 1000);
+    for (size_t i = 0; i < 1000; i++)
+    {
+        auto val = make_tick(i);
+        auto row = view.get(i);
+        ASSERT_EQ(row.time, std::chrono::microseconds(i));
+        ASSERT_EQ(row.price, val.price);
+        ASSERT_EQ(row.volume, val.volume);
+        ASSERT_EQ(row.bid, 0);
+        ASSERT_EQ(std::string(row.symbol), val.symbol);
+    }
+
+    mio::tsdb::table<market::tick_v2> table("binary_v2.db", 4096);
+    ASSERT_EQ(mio::serialization::binary_load(std::istringstream(str), table), 1000);
+    ASSERT_EQ(table[999].value().volume, 899);
+
+    //类型不能转换
+    ASSERT_THROW(mio::serialization::binary_view<market::tick_bad>(data, str.size()), std::runtime_error);
+
+    //截断的记录
+    ASSERT_THROW(mio::serialization::binary_load(std::istringstream(str.substr(0, str.size() - 1)), table), std::runtime_error);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,322 @@
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <mio/tsdb.hpp>
+#include <mio/serialization/csv.hpp>
+
+using mio::serialization::csv_type;
+
+constexpr size_t COUNT = 100000;
+
+std::string make_csv(size_t count)
+{
+    std::string ret = "id,price,time,symbol\n";
+    for (size_t i = 0; i < count; i++)
+    {
+        ret += std::to_string(i) + "," + std::to_string(i * 0.25) + ",2022-03-07 09:30:" + (i % 60 < 10 ? "0" : "") +
+               std::to_string(i % 60) + "." + std::to_string(i % 1000) + ",";
+        ret += i % 7 ? "IF2203\n" : "\"IF,\"\"22\"\"\n03\"\r\n";
+    }
+    return ret;
+}
+
+void verify(const mio::serialization::csv_table &table, size_t first, size_t count)
+{
+    auto &id = table["id"], &price = table["price"], &time = table["time"], &symbol = table["symbol"];
+    ASSERT_EQ(id.type, csv_type::int64);
+    ASSERT_EQ(price.type, csv_type::float64);
+    ASSERT_EQ(time.type, csv_type::timestamp);
+    ASSERT_EQ(symbol.type, csv_type::string);
+    ASSERT_EQ(table.rows(), count);
+
+    //2022-03-07 09:30:00 UTC
+    constexpr std::int64_t base = 1646645400;
+    for (size_t row = 0; row < count; row++)
+    {
+        size_t i = first + row;
+        ASSERT_EQ(id.int64[row], static_cast<std::int64_t>(i));
+        ASSERT_EQ(price.float64[row], std::stod(std::to_string(i * 0.25)));
+
+        std::int64_t frac = i % 1000;
+        frac *= frac < 10 ? 100000000 : frac < 100 ? 10000000
+                                                   : 1000000;
+        ASSERT_EQ(time.int64[row], (base + static_cast<std::int64_t>(i % 60)) * 1000000000 + frac);
+        ASSERT_EQ(symbol.string(row), i % 7 ? "IF2203" : "IF,\"22\"\n03");
+    }
+}
+
+TEST(csv, parse)
+{
+    auto str = make_csv(COUNT);
+
+    auto start = std::chrono::steady_clock::now();
+    auto table = mio::serialization::csv_parse(str);
+    auto end = std::chrono::steady_clock::now();
+    printf("parse ns/%lu MB/s/%lu\n", (end - start).count() / COUNT,
+           str.size() * 1000 / std::max<std::int64_t>((end - start).count(), 1));
+
+    verify(table, 0, COUNT);
+}
+
+TEST(csv, stream)
+{
+    auto str = make_csv(COUNT);
+
+    //缓冲区小于一行 以及行跨越缓冲区边界
+    for (size_t buffer_size : {7, 4096})
+    {
+        mio::serialization::csv_options options;
+        options.buffer_size = buffer_size;
+
+        std::istringstream stream(str);
+        auto table = mio::serialization::csv_read(stream, options);
+        verify(table, 0, COUNT);
+    }
+
+    std::istringstream stream(str);
+    size_t first = 0, batches = 0;
+    mio::serialization::csv_options options;
+    options.buffer_size = 1 << 16;
+    auto count = mio::serialization::csv_reader(options).read(
+        stream, [&](mio::serialization::csv_table &table)
+        {
+            verify(table, first, table.rows());
+            first += table.rows();
+            batches++; },
+        10000);
+    ASSERT_EQ(count, COUNT);
+    ASSERT_EQ(first, COUNT);
+    ASSERT_GT(batches, 5);
+}
+
+TEST(csv, file)
+{
+    auto str = make_csv(COUNT * 4);
+    {
+        std::ofstream file("csv_file.csv", std::ios::binary);
+        file << str;
+    }
+
+    for (size_t threads : {1, 4, 16})
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto table = mio::serialization::csv_read_file("csv_file.csv", {}, threads);
+        auto end = std::chrono::steady_clock::now();
+        printf("threads/%lu MB/s/%lu\n", threads, str.size() * 1000 / std::max<std::int64_t>((end - start).count(), 1));
+
+        verify(table, 0, COUNT * 4);
+    }
+
+    //后面的块中推断为 float64 的列 合并时放宽
+    str = "a,b\n";
+    for (size_t i = 0; i < COUNT; i++)
+        str += std::to_string(i) + "," + (i < COUNT / 2 ? std::to_string(i) : std::to_string(i) + ".5") + "\n";
+    {
+        std::ofstream file("csv_file.csv", std::ios::binary);
+        file << str;
+    }
+
+    auto table = mio::serialization::csv_read_file("csv_file.csv", {}, 8);
+    ASSERT_EQ(table.rows(), COUNT);
+    ASSERT_EQ(table["b"].type, csv_type::float64);
+    for (size_t i = 0; i < COUNT; i++)
+        ASSERT_EQ(table["b"].float64[i], i < COUNT / 2 ? i : i + 0.5);
+
+    std::ofstream("csv_file.csv", std::ios::trunc).close();
+    ASSERT_EQ(mio::serialization::csv_read_file("csv_file.csv").rows(), 0);
+    std::remove("csv_file.csv");
+}
+
+TEST(csv, tsdb)
+{
+    enum class side : std::int8_t
+    {
+        sell = -1,
+        buy = 1,
+    };
+
+    struct tick
+    {
+        std::chrono::nanoseconds time;
+        double price;
+        std::int32_t id;
+        side dir;
+        bool ok;
+        char symbol[8];
+    };
+
+    std::string str = "id,price,time,symbol,side,ok,extra\n";
+    for (size_t i = 0; i < COUNT; i++)
+        str += std::to_string(i) + "," + std::to_string(i * 0.25) + "," + std::to_string(i * 1000) + ",IF" + std::to_string(i % 10000) + "," +
+               (i % 2 ? "1" : "-1") + "," + (i % 3 ? "true" : "false") + ",x\n";
+
+    std::vector<mio::serialization::csv_field<tick>> fields = {
+        {"time", &tick::time}, {"price", &tick::price}, {"id", &tick::id}, {"side", &tick::dir}, {"ok", &tick::ok}, {"symbol", &tick::symbol}};
+
+    mio::tsdb::table<tick> table("csv_tsdb.db", 4096);
+    std::istringstream stream(str);
+    ASSERT_EQ(mio::serialization::csv_import(stream, table, fields, {}, 10000), COUNT);
+
+    ASSERT_EQ(table.size(), COUNT);
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        auto &row = table[i].value();
+        ASSERT_EQ(row.time, std::chrono::microseconds(i));
+        ASSERT_EQ(row.price, std::stod(std::to_string(i * 0.25)));
+        ASSERT_EQ(row.id, static_cast<std::int32_t>(i));
+        ASSERT_EQ(row.dir, i % 2 ? side::buy : side::sell);
+        ASSERT_EQ(row.ok, i % 3 != 0);
+        ASSERT_EQ(std::string(row.symbol, strnlen(row.symbol, sizeof(row.symbol))), "IF" + std::to_string(i % 10000));
+    }
+
+    //时间戳列 换算为纳秒
+    mio::tsdb::table<tick> stamp("csv_tsdb_stamp.db", 4096);
+    mio::serialization::csv_append(mio::serialization::csv_parse("time,symbol\n1970-01-01 00:00:01.5,123456789\n"), stamp, {{"time", &tick::time}, {"symbol", &tick::symbol}});
+    ASSERT_EQ(stamp[0].value().time, std::chrono::milliseconds(1500));
+    ASSERT_EQ(std::string_view(stamp[0].value().symbol, 8), "12345678");
+
+    ASSERT_THROW(mio::serialization::csv_append(mio::serialization::csv_parse("a\n1\n"), stamp, {{"time", &tick::time}}), std::out_of_range);
+}
+
+TEST(csv, writer)
+{
+    //csv_table 写出后读回
+    auto str = make_csv(COUNT);
+    auto table = mio::serialization::csv_parse(str);
+
+    for (size_t buffer_size : {64, 1 << 20})
+    {
+        mio::serialization::csv_options options;
+        options.buffer_size = buffer_size;
+
+        std::ostringstream out;
+        auto start = std::chrono::steady_clock::now();
+        {
+            mio::serialization::csv_writer writer(out, options);
+            ASSERT_EQ(mio::serialization::csv_write(writer, table), COUNT);
+        }
+        auto end = std::chrono::steady_clock::now();
+        printf("write ns/%lu MB/s/%lu\n", (end - start).count() / COUNT,
+               out.str().size() * 1000 / std::max<std::int64_t>((end - start).count(), 1));
+
+        verify(mio::serialization::csv_parse(out.str()), 0, COUNT);
+    }
+
+    //tsdb::table 按列映射写出 到文件描述符
+    struct tick
+    {
+        std::chrono::nanoseconds time;
+        double price;
+        std::int32_t id;
+        char symbol[8];
+    };
+
+    std::vector<mio::serialization::csv_field<tick>> fields = {
+        {"time", &tick::time}, {"price", &tick::price}, {"id", &tick::id}, {"symbol", &tick::symbol}};
+
+    mio::tsdb::table<tick> ticks("csv_writer.db", 4096);
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        tick row{std::chrono::nanoseconds(i * 1000001), i * 0.5, static_cast<std::int32_t>(i) - 10, "IF"};
+        snprintf(row.symbol, sizeof(row.symbol), "IF%lu", i % 100000);
+        ticks.push(row);
+    }
+
+    {
+        auto file = std::fopen("csv_writer.csv", "w");
+        mio::serialization::csv_writer writer(fileno(file));
+        ASSERT_EQ(mio::serialization::csv_write(writer, ticks, 0, COUNT, fields), COUNT);
+        writer.flush();
+        std::fclose(file);
+    }
+
+    auto back = mio::serialization::csv_read_file("csv_writer.csv");
+    std::remove("csv_writer.csv");
+    ASSERT_EQ(back.rows(), COUNT);
+    ASSERT_EQ(back["time"].type, csv_type::timestamp);
+    ASSERT_EQ(back["id"].type, csv_type::int64);
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        ASSERT_EQ(back["time"].int64[i], static_cast<std::int64_t>(i * 1000001));
+        ASSERT_EQ(back["price"].float64[i], i * 0.5);
+        ASSERT_EQ(back["id"].int64[i], static_cast<std::int64_t>(i) - 10);
+        ASSERT_EQ(back["symbol"].string(i), "IF" + std::to_string(i % 100000));
+    }
+
+    //结构体序列 引号 nan 与负数时间
+    struct row
+    {
+        std::chrono::milliseconds time;
+        double value;
+        bool ok;
+    };
+    std::vector<row> rows = {{std::chrono::milliseconds(-1), NAN, true}, {std::chrono::milliseconds(86400000), 1.25, false}};
+
+    std::ostringstream out;
+    {
+        mio::serialization::csv_writer writer(out);
+        writer.row("a,b", std::string("\"q\""), 'c', -5);
+        mio::serialization::csv_write(writer, rows, {{"time", &row::time}, {"value", &row::value}, {"ok", &row::ok}}, false);
+    }
+    ASSERT_EQ(out.str(), "\"a,b\",\"\"\"q\"\"\",c,-5\n"
+                         "1969-12-31 23:59:59.999000000,,true\n"
+                         "1970-01-02 00:00:00,1.25,false\n");
+}
+
+TEST(csv, infer)
+{
+    auto table = mio::serialization::csv_parse("a,b,c,d\n1,1,2022-01-01,x\n2,1.5,,\n\n3,abc,2022-01-02T00:00:01Z,\"\"\n");
+    ASSERT_EQ(table.rows(), 3);
+
+    ASSERT_EQ(table["a"].type, csv_type::int64);
+    ASSERT_EQ(table["a"].int64, (std::vector<std::int64_t>{1, 2, 3}));
+
+    //int64 -> float64 -> string
+    ASSERT_EQ(table["b"].type, csv_type::string);
+    ASSERT_EQ(table["b"].string(0), "1");
+    ASSERT_EQ(table["b"].string(1), "1.5");
+    ASSERT_EQ(table["b"].string(2), "abc");
+
+    ASSERT_EQ(table["c"].type, csv_type::timestamp);
+    ASSERT_EQ(table["c"].int64, (std::vector<std::int64_t>{1640995200000000000, 0, 1641081601000000000}));
+
+    ASSERT_EQ(table["d"].type, csv_type::string);
+    ASSERT_EQ(table["d"].string(1), "");
+    ASSERT_EQ(table["d"].string(2), "");
+}
+
+TEST(csv, options)
+{
+    mio::serialization::csv_options options;
+    options.delimiter = '\t';
+    options.header = false;
+    options.types = {csv_type::float64, csv_type::string};
+
+    auto table = mio::serialization::csv_parse("1\ta b\n\t\"c\td\"", options);
+    ASSERT_EQ(table.rows(), 2);
+    ASSERT_EQ(table["0"].float64[0], 1);
+    ASSERT_TRUE(std::isnan(table["0"].float64[1]));
+    ASSERT_EQ(table["1"].string(0), "a b");
+    ASSERT_EQ(table["1"].string(1), "c\td");
+
+    //指定类型时不放宽
+    options.types = {csv_type::int64, csv_type::string};
+    ASSERT_THROW(mio::serialization::csv_parse("1\ta\n1.5\tb\n", options), std::runtime_error);
+
+    ASSERT_THROW(mio::serialization::csv_parse("a,b\n1\n"), std::runtime_error);
+    ASSERT_THROW(mio::serialization::csv_parse("a,b\n1,\"2\n"), std::runtime_error);
+    ASSERT_THROW(mio::serialization::csv_parse("a,b\n1,\"2\"3\n"), std::runtime_error);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
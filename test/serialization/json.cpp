@@ -0,0 +1,174 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <mio/serialization/json.hpp>
+
+constexpr size_t COUNT = 100000;
+
+namespace market
+{
+    enum class side : std::int8_t
+    {
+        sell = -1,
+        buy = 1,
+    };
+
+    struct tick
+    {
+        std::chrono::nanoseconds time;
+        double price;
+        std::int32_t volume;
+        side dir;
+        char symbol[8];
+    };
+
+    MIO_REFLECT(tick, time, price, volume, dir, symbol)
+
+    struct snapshot
+    {
+        std::string name;
+        std::vector<tick> ticks;
+        std::optional<double> limit;
+        std::map<std::string, int> counts;
+        int levels[3];
+        bool ok;
+        mio::serialization::json_value extra;
+    };
+
+    MIO_REFLECT(snapshot, name, ticks, limit, counts, levels, ok, extra)
+} // namespace market
+
+using market::tick;
+
+std::string make_json(size_t count)
+{
+    std::string ret = "{\"name\": \"snap\", \"ignored\": {\"a\": [1, \"]}\", {\"b\": null}]}, \"ticks\": [\n";
+    for (size_t i = 0; i < count; i++)
+    {
+        ret += (i ? ",\n" : "") + std::string("  {\"time\": ") + std::to_string(i * 1000) + ", \"price\": " + std::to_string(i * 0.25) +
+               ", \"volume\": " + std::to_string(i) + ", \"dir\": " + (i % 2 ? "1" : "-1") + ", \"symbol\": \"IF" + std::to_string(i % 10000) + "\"}";
+    }
+    ret += "], \"ok\": true}";
+    return ret;
+}
+
+TEST(json, parse)
+{
+    auto str = make_json(COUNT);
+
+    auto start = std::chrono::steady_clock::now();
+    auto snap = mio::serialization::json_parse<market::snapshot>(str);
+    auto end = std::chrono::steady_clock::now();
+    printf("parse ns/%lu MB/s/%lu\n", (end - start).count() / COUNT,
+           str.size() * 1000 / std::max<std::int64_t>((end - start).count(), 1));
+
+    ASSERT_EQ(snap.name, "snap");
+    ASSERT_TRUE(snap.ok);
+    ASSERT_FALSE(snap.limit);
+    ASSERT_EQ(snap.ticks.size(), COUNT);
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        auto &row = snap.ticks[i];
+        ASSERT_EQ(row.time, std::chrono::microseconds(i));
+        ASSERT_EQ(row.price, std::stod(std::to_string(i * 0.25)));
+        ASSERT_EQ(row.volume, static_cast<std::int32_t>(i));
+        ASSERT_EQ(row.dir, i % 2 ? market::side::buy : market::side::sell);
+        ASSERT_EQ(std::string(row.symbol), "IF" + std::to_string(i % 10000));
+    }
+
+    //与 json_dump 往返
+    auto text = mio::serialization::json_dump(snap.ticks[7]);
+    auto back = mio::serialization::json_parse<tick>(text);
+    ASSERT_EQ(mio::serialization::json_dump(back), text);
+}
+
+TEST(json, types)
+{
+    auto snap = mio::serialization::json_parse<market::snapshot>(
+        R"( { "name" : "a\"b\\cé😀\n", "limit": 1.5e2, "counts": {"x": 1, "y\/z": -2},
+              "levels": [1, 2, 3, 4], "ok": false, "extra": {"deep": [1, 2, {"k": "v"}]}, "ticks": [] } )");
+
+    ASSERT_EQ(snap.name, "a\"b\\c\xc3\xa9\xf0\x9f\x98\x80\n");
+    ASSERT_EQ(snap.limit, 150);
+    ASSERT_EQ(snap.counts, (std::map<std::string, int>{{"x", 1}, {"y/z", -2}}));
+    ASSERT_EQ(snap.levels[2], 3);
+    ASSERT_FALSE(snap.ok);
+    ASSERT_TRUE(snap.ticks.empty());
+
+    //json_value 成员只保存位置 按需访问
+    ASSERT_EQ(snap.extra.type(), mio::serialization::json_type::object);
+    ASSERT_EQ(snap.extra.raw(), R"({"deep": [1, 2, {"k": "v"}]})");
+    ASSERT_EQ(snap.extra["deep"][2]["k"].get<std::string>(), "v");
+
+    //null 与缺少的成员保持原值
+    market::snapshot value{};
+    value.limit = 1;
+    value.name = "keep";
+    mio::serialization::json_parse(R"({"limit": null, "name": null})", value);
+    ASSERT_FALSE(value.limit);
+    ASSERT_EQ(value.name, "keep");
+
+    ASSERT_THROW(mio::serialization::json_parse<tick>(R"({"price": 1.5x})"), std::runtime_error);
+    ASSERT_THROW(mio::serialization::json_parse<tick>(R"({"volume": 1.5})"), std::runtime_error);
+    ASSERT_THROW(mio::serialization::json_parse<tick>(R"({"symbol": "IF)"), std::runtime_error);
+    ASSERT_THROW(mio::serialization::json_parse<tick>(R"({"price": 1} x)"), std::runtime_error);
+    ASSERT_THROW(mio::serialization::json_parse<tick>(R"({"price" 1})"), std::runtime_error);
+}
+
+TEST(json, value)
+{
+    auto str = make_json(COUNT);
+    {
+        std::ofstream file("json_value.json", std::ios::binary);
+        file << str;
+    }
+
+    mio::serialization::json_file file("json_value.json");
+    auto root = file.root();
+    ASSERT_EQ(root.type(), mio::serialization::json_type::object);
+    ASSERT_EQ(root.size(), 4);
+    ASSERT_EQ(root["name"].get<std::string>(), "snap");
+    ASSERT_FALSE(root.find("missing"));
+    ASSERT_THROW(root["missing"], std::out_of_range);
+
+    //只访问需要的路径
+    auto start = std::chrono::steady_clock::now();
+    auto price = root.at_pointer("/ticks/99999/price");
+    auto end = std::chrono::steady_clock::now();
+    printf("pointer ns/%lu MB/s/%lu\n", (end - start).count(),
+           str.size() * 1000 / std::max<std::int64_t>((end - start).count(), 1));
+
+    ASSERT_TRUE(price);
+    ASSERT_EQ(price->get<double>(), std::stod(std::to_string(99999 * 0.25)));
+    ASSERT_EQ(root.at_pointer("/ignored/a/1")->get<std::string>(), "]}");
+    ASSERT_FALSE(root.at_pointer("/ticks/100000"));
+    ASSERT_FALSE(root.at_pointer("/name/x"));
+
+    size_t count = 0;
+    root["ticks"].for_each([&](mio::serialization::json_value value)
+                           {
+        count++;
+        return value["volume"].get<int>() < 9; });
+    ASSERT_EQ(count, 10);
+
+    std::vector<std::string> keys;
+    root.for_each([&](std::string_view key, mio::serialization::json_value)
+                  { keys.emplace_back(key); });
+    ASSERT_EQ(keys, (std::vector<std::string>{"name", "ignored", "ticks", "ok"}));
+
+    std::remove("json_value.json");
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,163 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <mio/tsdb.hpp>
+#include <mio/serialization/arrow.hpp>
+#include <mio/serialization/csv.hpp>
+#include <mio/serialization/json.hpp>
+
+constexpr size_t COUNT = 10000;
+
+namespace market
+{
+    enum class side : std::int8_t
+    {
+        sell = -1,
+        buy = 1,
+    };
+
+    struct tick
+    {
+        std::chrono::nanoseconds time;
+        double price;
+        std::int32_t volume;
+        side dir;
+        bool ok;
+        char symbol[8];
+    };
+
+    MIO_REFLECT(tick, time, price, volume, dir, ok, symbol)
+
+    tick make_tick(size_t i)
+    {
+        tick ret{std::chrono::nanoseconds(i * 1000), i * 0.25, static_cast<std::int32_t>(i), i % 2 ? side::buy : side::sell, i % 3 == 0, "IF"};
+        snprintf(ret.symbol, sizeof(ret.symbol), "IF%lu", i % 10000);
+        return ret;
+    }
+
+    bool operator==(const tick &a, const tick &b)
+    {
+        return a.time == b.time && a.price == b.price && a.volume == b.volume && a.dir == b.dir && a.ok == b.ok &&
+               std::memcmp(a.symbol, b.symbol, sizeof(a.symbol)) == 0;
+    }
+} // namespace market
+
+using market::tick;
+
+TEST(reflect, fields)
+{
+    static_assert(mio::serialization::is_reflectable_v<tick>);
+    static_assert(!mio::serialization::is_reflectable_v<int>);
+    static_assert(mio::serialization::reflect_size_v<tick> == 6);
+
+    constexpr auto names = mio::serialization::reflect_names<tick>();
+    static_assert(names[0] == "time" && names[5] == "symbol");
+
+    auto price = std::get<1>(mio::serialization::reflect_fields<tick>());
+    ASSERT_EQ(price.offset(), offsetof(tick, price));
+
+    auto val = market::make_tick(7);
+    price.get(val) = 1.5;
+    ASSERT_EQ(val.price, 1.5);
+
+    //局部类型 在定义内描述
+    struct point
+    {
+        int x;
+        int y;
+        MIO_REFLECT_MEMBERS(point, x, y)
+    };
+
+    point p{1, 2};
+    int sum = 0;
+    mio::serialization::reflect_for_each(p, [&](std::string_view name, int &value)
+                                         { sum += name == "x" ? value : value * 10; });
+    ASSERT_EQ(sum, 21);
+}
+
+TEST(reflect, csv)
+{
+    mio::tsdb::table<tick> src("reflect_csv_src.db", 4096);
+    for (size_t i = 0; i < COUNT; i++)
+        src.push(market::make_tick(i));
+
+    //列映射由描述生成
+    std::ostringstream out;
+    {
+        mio::serialization::csv_writer writer(out);
+        ASSERT_EQ(mio::serialization::csv_write(writer, src, 0, COUNT), COUNT);
+    }
+    ASSERT_EQ(out.str().substr(0, out.str().find('\n')), "time,price,volume,dir,ok,symbol");
+
+    std::vector<tick> dst;
+    struct sink
+    {
+        using value_type = tick;
+        std::vector<tick> &rows;
+        void push(const tick &value) { rows.push_back(value); }
+    } table{dst};
+
+    //写出的 duration 为时间戳 读回为纳秒
+    std::istringstream in(out.str());
+    ASSERT_EQ(mio::serialization::csv_import(in, table), COUNT);
+    for (size_t i = 0; i < COUNT; i++)
+        ASSERT_EQ(dst[i], market::make_tick(i));
+}
+
+TEST(reflect, arrow)
+{
+    mio::tsdb::table<tick> src("reflect_arrow_src.db", 4096);
+    for (size_t i = 0; i < COUNT; i++)
+        src.push(market::make_tick(i));
+
+    auto fields = mio::serialization::arrow_fields<tick>();
+    ASSERT_EQ(fields.size(), 6);
+    ASSERT_EQ(fields[2].name, "volume");
+    ASSERT_EQ(fields[2].offset, offsetof(tick, volume));
+
+    std::stringstream stream;
+    ASSERT_EQ(mio::serialization::arrow_dump(stream, src, 0, COUNT, fields), COUNT);
+
+    mio::tsdb::table<tick> dst("reflect_arrow_dst.db", 4096);
+    ASSERT_EQ(mio::serialization::arrow_load(stream, dst, fields), COUNT);
+    for (size_t i = 0; i < COUNT; i++)
+        ASSERT_EQ(dst[i].value(), market::make_tick(i));
+}
+
+namespace market
+{
+    struct order
+    {
+        std::string account;
+        std::vector<tick> ticks;
+        std::optional<double> limit;
+        std::optional<double> stop;
+    };
+
+    MIO_REFLECT(order, account, ticks, limit, stop)
+} // namespace market
+
+TEST(reflect, json)
+{
+    market::order order{"a\"1\n", {market::make_tick(1), market::make_tick(2)}, 2.5, std::nullopt};
+    order.ticks[1].price = NAN;
+
+    ASSERT_EQ(mio::serialization::json_dump(order),
+              "{\"account\":\"a\\\"1\\n\",\"ticks\":["
+              "{\"time\":1000,\"price\":0.25,\"volume\":1,\"dir\":1,\"ok\":false,\"symbol\":\"IF1\"},"
+              "{\"time\":2000,\"price\":null,\"volume\":2,\"dir\":-1,\"ok\":false,\"symbol\":\"IF2\"}],"
+              "\"limit\":2.5,\"stop\":null}");
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
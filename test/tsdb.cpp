@@ -119,6 +119,36 @@ TEST(tsdb, tsdb)
     v.run<64, 128, 256, 512, 1024>();
 }
 
+TEST(tsdb, statistics)
+{
+    mio::tsdb::table<size_t> table("stat.db", 16);
+    for (size_t i = 0; i < 100; i++)
+        table.push(i);
+
+    auto stat = table.stat();
+    ASSERT_EQ(stat.size, 100);
+    ASSERT_EQ(stat.capacity, 128);
+    ASSERT_EQ(stat.recapacity, 3);
+    ASSERT_EQ(stat.remap, 3);
+    ASSERT_EQ(stat.parked, 0);
+
+    std::thread th([&]()
+                   {
+        mio::tsdb::table<size_t> reader("stat.db");
+        ASSERT_EQ(reader.wait(100).value(), 100); });
+
+    while (mio::tsdb::stat("stat.db").parked == 0)
+        std::this_thread::yield();
+
+    table.push(100);
+    th.join();
+
+    stat = mio::tsdb::stat("stat.db");
+    ASSERT_EQ(stat.row_wait, 1);
+    ASSERT_EQ(stat.parked, 0);
+    ASSERT_EQ(stat.ref_cout, 1);
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);